@@ -38,7 +38,7 @@ void Sconst::printOn(std::ostream &out) const {
 	out<< "\""<<str<<"\"";
 }
 
-Id::Id(std::string v): name(v), type(nullptr) {}
+Id::Id(std::string v): name(v), type(nullptr), constant(nullptr) {}
 void Id::printOn(std::ostream &out) const {
 	out << name;
 }
@@ -134,11 +134,34 @@ void While::printOn(std::ostream &out) const {
 	out << "While(" << *expr << "do" << *stmt << ")";
 }
 
+For::For(Id* c, Expr* f, Expr* t, Stmt* s, bool d):
+	counter(c),from(f),to(t),stmt(s),down(d){}
+void For::printOn(std::ostream &out) const {
+	out << "For(" << *counter << ":=" << *from << (down ? "downto" : "to")
+		<< *to << "do" << *stmt << ")";
+}
+
+CaseArm::CaseArm(ExprList* l, Stmt* s):labels(l),stmt(s){}
+void CaseArm::printOn(std::ostream &out) const {
+	out << "CaseArm(" << *labels << ":" << *stmt << ")";
+}
 
-New::New(LValue* lval, Expr* e):expr(e),lvalue(lval){}
-New::~New(){delete expr; delete lvalue;}
+Case::Case(Expr* e, List<CaseArm>* a, Stmt* o):expr(e),arms(a),other(o){}
+void Case::printOn(std::ostream &out) const {
+	if (other)
+	out << "Case(" << *expr << "of" << *arms << "else" << *other << ")";
+	else
+	out << "Case(" << *expr << "of" << *arms << ")";
+}
+
+
+New::New(LValue* lval, Expr* e):expr(e),dims(nullptr),lvalue(lval){}
+New::New(LValue* lval, ExprList* d):expr(nullptr),dims(d),lvalue(lval){}
+New::~New(){delete expr; delete dims; delete lvalue;}
 void New::printOn(std::ostream &out) const{
-	if(expr)
+	if(dims)
+		out << "New( [" << *dims << "] " << *lvalue << ")";
+	else if(expr)
 		out << "New( [" << *expr << "] " << *lvalue << ")";
 	else
 		out << "New( [] of " << *lvalue << ")";
@@ -193,24 +216,47 @@ void LabelDecl::printOn(std::ostream &out) const {
 
 
 
-VarDecl::VarDecl(Decl* d):Decl(d->get_id(),"var"),type(nullptr){delete d;}
-VarDecl::VarDecl(Decl* d,TSPtr t):Decl(d->get_id(),"var"),type(t){delete d;}
+VarDecl::VarDecl(Decl* d):Decl(d->get_id(),"var"),type(nullptr),init(nullptr){
+	copy_parse_info(d); delete d;}
+VarDecl::VarDecl(Decl* d,TSPtr t,Initializer* i):
+	Decl(d->get_id(),"var"),type(t),init(i){copy_parse_info(d); delete d;}
 void VarDecl::printOn(std::ostream &out) const{
-	if(type)
+	if(type and init)
+	out << "VarDecl(" <<id<<" of type "<< *type << " = " << *init << ")";
+	else if(type)
 	out << "VarDecl(" <<id<<" of type "<< *type << ")";
 	else
 	out << "VarDecl(" <<id<<" of type NOTSET)";
 }
 
+Initializer::Initializer(Expr* e):value(e),is_string(false),items(nullptr){}
+Initializer::Initializer(std::string s):
+	value(nullptr),str(s),is_string(true),items(nullptr){}
+Initializer::Initializer(List<Initializer>* l):
+	value(nullptr),is_string(false),items(l){}
+void Initializer::printOn(std::ostream &out) const{
+	if(value)
+	out << *value;
+	else if(is_string)
+	out << "\"" << str << "\"";
+	else
+	out << "(" << *items << ")";
+}
+
+ConstDecl::ConstDecl(Decl* d, Expr* v):Decl(d->get_id(),"const"),value(v){delete d;}
+void ConstDecl::printOn(std::ostream &out) const{
+	out << "ConstDecl(" <<id<<" = "<< *value << ")";
+}
+
 FormalDecl::FormalDecl(Decl *d, bool ref):VarDecl(d), byRef(ref){}
 FormalDecl::FormalDecl(Decl* d,TSPtr t,bool ref):VarDecl(d,t), byRef(ref){}
 bool FormalDecl::isByRef(){return byRef;}
 
 DeclList::DeclList(Decl* d):List<Decl>(d){}
 DeclList::DeclList():List<Decl>(){}
-void DeclList::toVar(TSPtr t){
+void DeclList::toVar(TSPtr t, Initializer* init){
 	for(auto p=list.begin();p!=list.end();p++){
-		Decl *d=new VarDecl(*p,t);
+		Decl *d=new VarDecl(*p,t,init);
 		*p=d;
 	}
 }
@@ -252,6 +298,18 @@ void Procedure::toForward(){
 bool Procedure::isForward(){
 	return is_forward;
 }
+void Procedure::toPure(){
+	is_pure=true;
+}
+bool Procedure::isPure(){
+	return is_pure;
+}
+void Procedure::toReadOnly(){
+	is_readonly=true;
+}
+bool Procedure::isReadOnly(){
+	return is_readonly;
+}
 
 Function::Function(std::string name, DeclList *decl_list, TSPtr return_type, Body* bod)
 	:Procedure(name,decl_list,bod,"function"), ret_type(return_type){}
@@ -7,6 +7,7 @@ Contains class declarations for AST and all
 #include <iostream>
 #include <memory>
 #include <map>
+#include <set>
 #include <vector>
 #include <string>
 #include <cstring>
@@ -39,6 +40,8 @@ using TSPtr = SPtr<Type>;
 
 
 class LValue;
+class Id;
+class ExprList;
 struct FunctionEntry;
 
 class AST {
@@ -47,6 +50,9 @@ public:
 		location = loc;
 		strncpy(linebuf,buf,500);
 	}
+	void copy_parse_info(const AST* from){
+		add_parse_info(from->location, const_cast<char*>(from->linebuf));
+	}
 	virtual ~AST() {}
 	virtual void printOn(std::ostream &out) const {out<<"";}
 	virtual void sem(){}
@@ -90,6 +96,10 @@ public:
 
 	bool is_incomplete();
 
+	// replaces constant names used as array sizes by their values;
+	//   a bad size is reported at the declaration 'where'.
+	virtual void resolve_sizes(AST* where){}
+
 protected:
 	std::string name;
 };
@@ -228,6 +238,8 @@ public:
 
 	virtual bool doCompare(TSPtr t) override;
 
+	virtual void resolve_sizes(AST* where) override;
+
 	virtual llvm::Type* cgen() override;
 protected:
 	TSPtr type;
@@ -237,24 +249,68 @@ protected:
 class ArrType: public PtrType{
 public:
 	ArrType(int s,TSPtr t);
+	// size given by the name of a constant.
+	ArrType(std::string s,TSPtr t);
 	ArrType(TSPtr t);
 
 	// virtual Type* clone() override;
 
 	int get_size();
 
+	virtual int get_rank();
+
+	virtual bool is_packed();
+
 	virtual bool doCompare(TSPtr t) override;
 
 	virtual void printOn(std::ostream &out) const override;
 	bool is_1D();
+	virtual void resolve_sizes(AST* where) override;
 	virtual llvm::Type* cgen() override;
+
+	// address of an array without static size ('array of t', of an
+	//   'array [,] of t' and so on): pointer to its first element and
+	//   its extents.
+	llvm::Type* cgen_descriptor();
 protected:
 	int size;
+	// constant that gives the size (until it is resolved).
+	std::string size_name;
+};
+
+class MultiArrType: public ArrType{
+public:
+	// contiguous row-major array with 'rank' dynamic dimensions
+	//   ('array [,] of t'); a pointer to it carries the extents.
+	MultiArrType(int r, TSPtr t);
+
+	virtual int get_rank() override;
+
+	virtual void printOn(std::ostream &out) const override;
+protected:
+	int rank;
+};
+
+class PackedArrType: public ArrType{
+public:
+	// 'packed array [s] of boolean' (or without size); one bit per
+	//   element, stored in 64-bit words.
+	PackedArrType(int s);
+	PackedArrType(std::string s);
+
+	virtual bool is_packed() override;
+
+	virtual void printOn(std::ostream &out) const override;
+
+	virtual llvm::Type* cgen() override;
 };
 
 class FormalDeclList;
 class CallableType: public Type{
 public:
+	// memory visible to the caller that a call may touch (ordered).
+	enum Effect{ NoMemory=0, ReadsMemory, WritesMemory };
+
 	CallableType(std::string func_type, FormalDeclList* formals);
 	virtual bool should_delete() const override;
 	void typecheck_args(std::vector<TSPtr> arg_types);
@@ -272,12 +328,58 @@ public:
 
 	std::vector<std::string> get_formal_vars();
 
+	void add_captured(std::string name);
+
+	bool may_capture(uint i);
+
+	void add_addr_taken(std::string name);
+
+	std::set<std::string> get_addr_taken();
+
+	void add_callee(CallableType* callee);
+
+	bool is_recursive();
+
+	void set_analyzed();
+
+	void set_library();
+
+	bool is_by_ref_param(std::string name);
+
+	void add_written(std::string name);
+
+	bool by_pointer(uint i);
+
+	bool is_by_pointer_param(std::string name);
+
+	bool shares_array(uint i);
+
+	void add_effect(Effect eff);
+
+	Effect get_effect();
+
+	void cgen_attributes(llvm::Function* F);
+
 protected:
 	std::vector<TSPtr> formal_types;
 	std::vector<std::string> formal_vars;
 	std::vector<bool> by_ref;
 	std::vector<std::string> outer_vars;
 	std::vector<TSPtr> outer_types;
+	// by-reference parameters whose address may outlive a call.
+	std::set<std::string> captured;
+	// locals and parameters that need memory (can't be kept in SSA form).
+	std::set<std::string> addr_taken;
+	// locals and parameters assigned to (as a whole or in part).
+	std::set<std::string> written;
+	// user subprograms called directly from the body.
+	std::vector<CallableType*> callees;
+	// effect of the body itself (without user subprogram calls).
+	Effect local_effect;
+	bool analyzed;
+	// built-in; arrays are passed to the runtime as plain pointers.
+	bool library;
+	std::string param_name(uint i);
 	std::vector<llvm::Type*> cgen_argTypes();
 };
 
@@ -344,6 +446,11 @@ public:
 	bool isConst(){
 		return is_const;
 	}
+	// variable whose storage this lvalue addresses (if any).
+	virtual Id* get_root(){return nullptr;}
+	// element without an address of its own (bit of packed array).
+	virtual bool is_bit(){return false;}
+	virtual void cgen_store(llvm::Value* v);
 protected:
 	bool dynamic;
 	bool is_const;
@@ -365,6 +472,7 @@ public:
 	Iconst(int n);
 	virtual void printOn(std::ostream &out) const override;
 	virtual llvm::Value* cgen() override;
+	int get_num(){return num;}
 private:
 	int num;
 };
@@ -374,6 +482,7 @@ public:
 	Cconst(char c);
 	virtual void printOn(std::ostream &out) const override ;
 	virtual llvm::Value* cgen() override;
+	char get_char(){return ch;}
 private:
 	char ch;
 };
@@ -404,9 +513,15 @@ public:
 	virtual void sem() override;
 	virtual TSPtr get_type() override;
 	virtual llvm::Value* getAddr() override;
+	virtual Id* get_root() override{return this;}
+	virtual void cgen_store(llvm::Value* v) override;
+	std::string get_name(){return name;}
+	// literal of a named constant (nullptr for a variable).
+	Const* get_constant(){return constant;}
 private:
 	std::string name;
 	TSPtr type;
+	Const* constant;
 
 	virtual llvm::Value* cgen() override;
 };
@@ -417,6 +532,7 @@ public:
 	Bconst(bool b);
 	virtual void printOn(std::ostream &out) const override;
 	virtual llvm::Value* cgen() override;
+	bool get_bool(){return boo;}
 private:
 	bool boo;
 };
@@ -475,6 +591,8 @@ public:
 	virtual llvm::Value* cgen() override;
 
 	virtual llvm::Value* getAddr() override;
+
+	virtual Id* get_root() override;
 protected:
 	Expr *expr;
 	int count;
@@ -494,6 +612,12 @@ public:
 	virtual llvm::Value* cgen() override;
 
 	virtual llvm::Value* getAddr() override;
+
+	virtual Id* get_root() override{return lvalue->get_root();}
+
+	virtual bool is_bit() override;
+
+	virtual void cgen_store(llvm::Value* v) override;
 protected:
 	LValue* element();
 	LValue* lvalue;
@@ -561,15 +685,32 @@ private:
 	Stmt *stmt;
 };
 
+class For: public Stmt {
+public:
+	For(Id* c, Expr* f, Expr* t, Stmt* s, bool down);
+	virtual void printOn(std::ostream &out) const override;
+	virtual void sem() override;
+	virtual void cgen() override;
+private:
+	Id *counter;
+	Expr *from, *to;
+	Stmt *stmt;
+	// 'downto' loop.
+	bool down;
+};
+
 class New: public Stmt{
 public:
 	New(LValue* lval, Expr* e);
+	New(LValue* lval, ExprList* d);
 	~New();
 	virtual void printOn(std::ostream &out) const override;
 	virtual void sem() override;
 	virtual void cgen() override;
 protected:
 	Expr* expr;
+	// extents of a multi-dimensional array ('new [n, m] p').
+	ExprList* dims;
 	LValue* lvalue;
 };
 
@@ -657,6 +798,30 @@ public:
 	virtual std::vector<llvm::Value*> cgen(std::vector<bool> by_ref);
 };
 
+class CaseArm: public AST {
+public:
+	CaseArm(ExprList* l, Stmt* s);
+	virtual void printOn(std::ostream &out) const override;
+	friend class Case;
+private:
+	// constant labels of the arm.
+	ExprList *labels;
+	Stmt *stmt;
+};
+
+class Case: public Stmt {
+public:
+	Case(Expr* e, List<CaseArm>* a, Stmt* o);
+	virtual void printOn(std::ostream &out) const override;
+	virtual void sem() override;
+	virtual void cgen() override;
+private:
+	Expr *expr;
+	List<CaseArm> *arms;
+	// 'else' statement (if any).
+	Stmt *other;
+};
+
 class Decl: public AST{
 public:
 	Decl(std::string i):id(i),decl_type("unknown"){}
@@ -672,6 +837,25 @@ protected:
 	std::string decl_type;
 };
 
+class Initializer: public AST{
+public:
+	// single constant element.
+	Initializer(Expr* e);
+	// string for an array of char.
+	Initializer(std::string s);
+	// '(' items ')' for an array.
+	Initializer(List<Initializer>* l);
+	virtual void printOn(std::ostream &out) const override;
+	// checks that the initializer fits a variable of type t.
+	void typecheck(TSPtr t);
+	llvm::Constant* cgen(TSPtr t);
+private:
+	Expr* value;
+	std::string str;
+	bool is_string;
+	List<Initializer>* items;
+};
+
 class LabelDecl:public Decl{
 public:
 	LabelDecl(Decl* d);
@@ -684,7 +868,7 @@ public:
 class VarDecl: public Decl{
 public:
 	VarDecl(Decl* d);
-	VarDecl(Decl* d,TSPtr t);
+	VarDecl(Decl* d,TSPtr t,Initializer* i=nullptr);
 	virtual void printOn(std::ostream &out) const override;
 	virtual TSPtr get_type() override;
 	virtual void sem() override;
@@ -692,6 +876,20 @@ public:
 
 protected:
 	TSPtr type;
+	// static initial value (array variables only).
+	Initializer* init;
+};
+
+
+class ConstDecl: public Decl{
+public:
+	ConstDecl(Decl* d, Expr* v);
+	virtual void printOn(std::ostream &out) const override;
+	virtual TSPtr get_type() override;
+	virtual void sem() override;
+protected:
+	// literal, or name of another constant.
+	Expr* value;
 };
 
 
@@ -708,7 +906,7 @@ class DeclList: public List<Decl>{
 public:
 	DeclList(Decl* d);
 	DeclList();
-	void toVar(TSPtr t);
+	void toVar(TSPtr t, Initializer* init=nullptr);
 	virtual void sem() override;
 
 	void toLabel();
@@ -762,12 +960,24 @@ public:
 	void toForward();
 
 	bool isForward();
+
+	void toPure();
+
+	bool isPure();
+
+	void toReadOnly();
+
+	bool isReadOnly();
 protected:
 	void sem_helper(bool isFunction=false, TSPtr ret_type=nullptr);
 	Body* body;
 	FormalDeclList* formals;
 	SPtr<CallableType> type;
 	bool is_forward=false;
+	// library subprogram without side effects.
+	bool is_pure=false;
+	// library subprogram that only reads its arguments.
+	bool is_readonly=false;
 };
 
 class Function:public Procedure{
@@ -802,12 +1012,14 @@ protected:
 	std::vector<bool> by_ref;
 	ExprList* outer_vars;
 	Body* body;
+	SPtr<CallableType> callee_type;
 
 	FunctionEntry* check_passing();
 
 	void add_outer();
 
 	llvm::Value* cgen_common();
+	bool unchanged_during_call(Expr* arg, llvm::Value* addr);
 	virtual void report_error_from_child(const char* msg)=0;
 };
 
@@ -1,37 +1,84 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include "ast.hpp"
+#include "llvm/IR/CFG.h"
 
 class CgenScope{
 public:
 	CgenScope(llvm::Function* func):
-		vars(), addrs(), functions(), labels(),
+		vars(), functions(), labels(),
 		TheFunction(func), CurrentBB(nullptr){}
 
-	llvm::Function* getFunction(){ return TheFunction; }
+	/* Scalars whose address is never taken are kept in SSA form;
+	   definitions are tracked per block and phis are built on the fly
+	   (Braun et al., "Simple and Efficient Construction of SSA Form"). */
 
-	llvm::AllocaInst* lookup(std::string name, bool& ref){
-		if (addrs.find(name) != addrs.end()){
-			ref=true;
-			return addrs[name];
-		}
-		else if (vars.find(name) != vars.end()){
-			ref=false;
-			return vars[name];
+	void set_addr_taken(std::set<std::string> names){
+		addr_taken = names;
+	}
+
+	bool is_addr_taken(std::string name){
+		return addr_taken.find(name) != addr_taken.end();
+	}
+
+	void insert_ssa(std::string name, llvm::Type* ty){
+		ssa_types[name] = ty;
+	}
+
+	bool is_ssa(std::string name){
+		return ssa_types.find(name) != ssa_types.end();
+	}
+
+	void write_var(std::string name, llvm::BasicBlock* BB, llvm::Value* v){
+		defs[name][BB] = v;
+	}
+
+	llvm::Value* read_var(std::string name, llvm::BasicBlock* BB){
+		if (defs[name].find(BB) != defs[name].end()){
+			// local value numbering
+			return defs[name][BB];
 		}
-		else{
-			return nullptr;
+		return read_var_recursive(name, BB);
+	}
+
+	void seal(llvm::BasicBlock* BB){
+		// all predecessors of BB are known; complete its phis.
+		sealed.insert(BB);
+		std::map<std::string, llvm::PHINode*> phis = incomplete[BB];
+		incomplete.erase(BB);
+		for(auto const &p: phis){
+			add_phi_operands(p.first, p.second);
 		}
 	}
 
-	void insert(std::string name, llvm::AllocaInst* alloca, bool ref){
-		if(ref){
-			addrs[name]= alloca;
+	void seal_remaining(){
+		// label blocks are sealed last; gotos may follow them.
+		for(auto const &l: labels){
+			if(l.second and sealed.find(l.second) == sealed.end()){
+				seal(l.second);
+			}
 		}
-		else{
-			vars[name] = alloca;
+		// drop phis that were found trivial.
+		for(auto phi: dead_phis){
+			phi->dropAllReferences();
 		}
+		for(auto phi: dead_phis){
+			phi->eraseFromParent();
+		}
+		dead_phis.clear();
+	}
+
+	llvm::Function* getFunction(){ return TheFunction; }
+
+	llvm::Value* lookup(std::string name){
+		if (vars.find(name) == vars.end()) return nullptr;
+		return vars[name];
+	}
+
+	void insert(std::string name, llvm::Value* alloca){
+		vars[name] = alloca;
 	}
 
 	void insert_function(std::string name, llvm::Function* func){
@@ -67,31 +114,130 @@ public:
 		return ExitBB;
 	}
 private:
-	std::map<std::string, llvm::AllocaInst*> vars;
-	std::map<std::string, llvm::AllocaInst*> addrs;
+	llvm::Value* read_var_recursive(std::string name, llvm::BasicBlock* BB){
+		llvm::Value* v;
+		if(sealed.find(BB) == sealed.end()){
+			// incomplete CFG; operands are added when block is sealed.
+			llvm::PHINode* phi = create_phi(name, BB);
+			incomplete[BB][name] = phi;
+			v = phi;
+		}
+		else if(llvm::pred_begin(BB) == llvm::pred_end(BB)){
+			// entry or unreachable block; variable is uninitialized.
+			v = llvm::UndefValue::get(ssa_types[name]);
+		}
+		else if(BB->getSinglePredecessor()){
+			// no phi needed
+			v = read_var(name, BB->getSinglePredecessor());
+		}
+		else{
+			// break potential cycles with operandless phi
+			llvm::PHINode* phi = create_phi(name, BB);
+			write_var(name, BB, phi);
+			v = add_phi_operands(name, phi);
+		}
+		write_var(name, BB, v);
+		return v;
+	}
+
+	llvm::PHINode* create_phi(std::string name, llvm::BasicBlock* BB){
+		// phis go before the first non-phi instruction of the block.
+		llvm::Instruction* first = BB->getFirstNonPHI();
+		if(first){
+			return llvm::PHINode::Create(ssa_types[name], 0, name, first);
+		}
+		return llvm::PHINode::Create(ssa_types[name], 0, name, BB);
+	}
+
+	llvm::Value* add_phi_operands(std::string name, llvm::PHINode* phi){
+		llvm::BasicBlock* BB = phi->getParent();
+		for(auto pred: llvm::predecessors(BB)){
+			phi->addIncoming(read_var(name, pred), pred);
+		}
+		return try_remove_trivial_phi(phi);
+	}
+
+	llvm::Value* try_remove_trivial_phi(llvm::PHINode* phi){
+		llvm::Value* same = nullptr;
+		for(auto &op: phi->incoming_values()){
+			if(op == same or op == phi){
+				// unique value or self-reference
+				continue;
+			}
+			if(same){
+				// phi merges at least two values: not trivial
+				return phi;
+			}
+			same = op;
+		}
+		if(!same){
+			// phi is unreachable or in the entry block
+			same = llvm::UndefValue::get(phi->getType());
+		}
+		// remember all users except the phi itself
+		std::vector<llvm::PHINode*> users;
+		for(auto u: phi->users()){
+			llvm::PHINode* p = llvm::dyn_cast<llvm::PHINode>(u);
+			if(p and p != phi) users.push_back(p);
+		}
+		phi->replaceAllUsesWith(same);
+		for(auto &d: defs){
+			for(auto &b: d.second){
+				if(b.second == phi) b.second = same;
+			}
+		}
+		dead_phis.insert(phi);
+		// try to recursively remove all phi users, which might have
+		//   become trivial
+		for(auto p: users){
+			if(dead_phis.find(p) == dead_phis.end()){
+				try_remove_trivial_phi(p);
+			}
+		}
+		return same;
+	}
+
+	std::map<std::string, llvm::Value*> vars;
 	std::map<std::string, llvm::Function*> functions;
 	std::map<std::string, llvm::BasicBlock*> labels;
 	llvm::Function *TheFunction;
 	llvm::BasicBlock* CurrentBB;
 	llvm::BasicBlock* ExitBB;
 
+	std::set<std::string> addr_taken;
+	std::map<std::string, llvm::Type*> ssa_types;
+	std::map<std::string, std::map<llvm::BasicBlock*, llvm::Value*> > defs;
+	std::map<llvm::BasicBlock*, std::map<std::string, llvm::PHINode*> > incomplete;
+	std::set<llvm::BasicBlock*> sealed;
+	std::set<llvm::PHINode*> dead_phis;
 };
 
 
 class CgenTable{
 public:
-	CgenTable():scopes(){}
+	CgenTable():scopes(), globals(){}
 	void openScope(llvm::Function* func=nullptr){
 		scopes.push_back(CgenScope(func));
 	}
 	void closeScope(){
 		scopes.pop_back();
 	}
-	void insert(std::string name, llvm::AllocaInst* alloca, bool ref=false){
-		scopes.back().insert(name, alloca, ref);
+	void insert(std::string name, llvm::Value* alloca){
+		scopes.back().insert(name, alloca);
 	}
-	llvm::AllocaInst* lookup(std::string name, bool& ref){
-		return scopes.back().lookup(name, ref);
+	llvm::Value* lookup(std::string name){
+		llvm::Value* v = scopes.back().lookup(name);
+		if(v) return v;
+		// not local; must be a program-level variable.
+		if (globals.find(name) == globals.end()) return nullptr;
+		return globals[name];
+	}
+	void insert_global(std::string name, llvm::GlobalVariable* var){
+		globals[name]=var;
+	}
+	bool isGlobalScope(){
+		// scopes[0] holds library subprograms, scopes[1] is main.
+		return scopes.size()==2;
 	}
 	llvm::Function* getFunction(){
 		return scopes.back().getFunction();
@@ -125,6 +271,38 @@ public:
 		return scopes.back().getExitBB();
 	}
 
+	void set_addr_taken(std::set<std::string> names){
+		scopes.back().set_addr_taken(names);
+	}
+
+	bool is_addr_taken(std::string name){
+		return scopes.back().is_addr_taken(name);
+	}
+
+	void insert_ssa(std::string name, llvm::Type* ty){
+		scopes.back().insert_ssa(name, ty);
+	}
+
+	bool is_ssa(std::string name){
+		return scopes.back().is_ssa(name);
+	}
+
+	void write_var(std::string name, llvm::BasicBlock* BB, llvm::Value* v){
+		scopes.back().write_var(name, BB, v);
+	}
+
+	llvm::Value* read_var(std::string name, llvm::BasicBlock* BB){
+		return scopes.back().read_var(name, BB);
+	}
+
+	void seal(llvm::BasicBlock* BB){
+		scopes.back().seal(BB);
+	}
+
+	void seal_remaining(){
+		scopes.back().seal_remaining();
+	}
+
 	llvm::Function* function_lookup(std::string name){
 		for (auto i = scopes.rbegin(); i != scopes.rend(); ++i) {
 			llvm::Function *f = i->function_lookup(name);
@@ -138,6 +316,7 @@ public:
 	}
 private:
 	std::vector<CgenScope> scopes;
+	std::map<std::string, llvm::GlobalVariable*> globals;
 };
 
 CgenTable ct;
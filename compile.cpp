@@ -2,8 +2,25 @@
 #include "cgen_table.hpp"
 #include "library.hpp"
 #include "uid.hpp"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/SourceMgr.h"
+#include <cassert>
 
 const char *filename="llvm_output.out";
+// runtime library (lib.c) as LLVM bitcode; linked into the module if set.
+const char *runtime_bc=nullptr;
+// 'new' allocates from the runtime's collected heap; 'dispose' only clears.
+bool gc_heap=false;
+// array indices are checked against the array size.
+bool check_bounds=false;
 
 static llvm::LLVMContext TheContext;
 static llvm::IRBuilder<> Builder(TheContext);
@@ -63,7 +80,12 @@ std::vector<llvm::Type*> CallableType::cgen_argTypes(){
 	for(uint i=0; i<formal_types.size();i++){
 		if(by_ref[i]){
 			// by reference arguments need to have pointer type.
-			if(!formal_types[i]->get_name().compare("array")){
+			if(formal_types[i]->is_incomplete() and !library){
+				// 'array of' is passed with its length.
+				argTypes[i] = std::static_pointer_cast<ArrType>(formal_types[i])
+					->cgen_descriptor();
+			}
+			else if(!formal_types[i]->get_name().compare("array")){
 				// convert array by reference to pointer to element
 				argTypes[i] = llvm::PointerType::get(
 					std::dynamic_pointer_cast<ArrType >(formal_types[i])
@@ -73,13 +95,21 @@ std::vector<llvm::Type*> CallableType::cgen_argTypes(){
 				argTypes[i] = llvm::PointerType::get(formal_types[i]->cgen(), 0);
 			}
 		}
+		else if(by_pointer(i)){
+			// by-value array is passed as pointer to the whole array.
+			argTypes[i] = llvm::PointerType::get(formal_types[i]->cgen(), 0);
+		}
 		else{
 			argTypes[i] = formal_types[i]->cgen();
 		}
 	}
 	for(uint i=0; i<outer_types.size();i++){
 		// all outer arguments are passed by reference
-		if(!outer_types[i]->get_name().compare("array")){
+		if(outer_types[i]->is_incomplete()){
+			argTypes.push_back(std::static_pointer_cast<ArrType>(outer_types[i])
+				->cgen_descriptor());
+		}
+		else if(!outer_types[i]->get_name().compare("array")){
 			// convert array by reference to pointer to element
 			argTypes.push_back(
 				llvm::PointerType::get(
@@ -95,6 +125,52 @@ std::vector<llvm::Type*> CallableType::cgen_argTypes(){
 }
 
 
+void CallableType::cgen_attributes(llvm::Function* F){
+	const llvm::DataLayout &DL = TheModule->getDataLayout();
+	// pcl has no exceptions.
+	F->addFnAttr(llvm::Attribute::NoUnwind);
+	if(!is_recursive()){
+		F->addFnAttr(llvm::Attribute::NoRecurse);
+	}
+	switch(get_effect()){
+		case NoMemory:
+			F->addFnAttr(llvm::Attribute::ReadNone);
+			break;
+		case ReadsMemory:
+			F->addFnAttr(llvm::Attribute::ReadOnly);
+			break;
+		default:
+			break;
+	}
+	unsigned fs=formal_types.size();
+	for(uint i=0; i<fs+outer_types.size(); i++){
+		if(by_pointer(i)){
+			// the caller's array is only read (or copied on entry).
+			F->addParamAttr(i, llvm::Attribute::ReadOnly);
+			if(shares_array(i)){
+				// caller passes storage that no one writes during the call.
+				F->addParamAttr(i, llvm::Attribute::NoAlias);
+			}
+		}
+		// all outer arguments are passed by reference
+		else if(i<fs and !by_ref[i]) continue;
+		TSPtr t = i<fs ? formal_types[i] : outer_types[i-fs];
+		if(!F->getFunctionType()->getParamType(i)->isPointerTy()){
+			// descriptor of an 'array of'.
+			continue;
+		}
+		// by-reference argument is always the address of an lvalue.
+		F->addParamAttr(i, llvm::Attribute::NonNull);
+		if(!may_capture(i)){
+			F->addParamAttr(i, llvm::Attribute::NoCapture);
+		}
+		if(!t->is_incomplete()){
+			// whole object (or array) is accessible through the argument.
+			F->addDereferenceableParamAttr(i, DL.getTypeAllocSize(t->cgen()));
+		}
+	}
+}
+
 llvm::Type* FunctionType::cgen(){
 	// last argument is false for fixed number of arguments
 	return llvm::FunctionType::get(ret_type->cgen(), cgen_argTypes(), false);
@@ -106,9 +182,59 @@ llvm::Type* ProcedureType::cgen(){
 }
 
 llvm::Type* PtrType::cgen(){
+	if(type->is_incomplete()){
+		// pointer to dynamic array carries the extents.
+		return std::static_pointer_cast<ArrType>(type)->cgen_descriptor();
+	}
 	return llvm::PointerType::get(type->cgen(), 0);
 }
 
+llvm::Type* ArrType::cgen_descriptor(){
+	// {pointer to first element (word if packed), extent of every dimension}
+	llvm::Type* elemTy = is_packed() ? i64 : type->cgen();
+	return llvm::StructType::get(TheContext, std::vector<llvm::Type*>{
+		llvm::PointerType::get(elemTy, 0),
+		llvm::ArrayType::get(i32, get_rank())
+	});
+}
+
+static llvm::Value* cgen_cond(llvm::Value* v){
+	// boolean (i8) as branch condition; a comparison is used directly
+	//   so that loop conditions are visible to analyses.
+	if(llvm::ZExtInst* Z = llvm::dyn_cast<llvm::ZExtInst>(v)){
+		if(Z->getOperand(0)->getType()==i1) return Z->getOperand(0);
+	}
+	return Builder.CreateTrunc(v, i1, "cond");
+}
+
+static llvm::Value* data_pointer(llvm::Value* v){
+	// pointer value; for a dynamic array, its data pointer.
+	if(v->getType()->isStructTy()){
+		return Builder.CreateExtractValue(v, 0, "data");
+	}
+	return v;
+}
+
+static llvm::Value* cgen_descriptor_of(llvm::Value* v, TSPtr t,
+		llvm::Type* descTy){
+	/* address of a whole fixed array (or nil), of type t or pointer to
+	     t, as the descriptor of an 'array of'; the extent is its static
+	     size. */
+	if(v->getType()->isStructTy()) return v;
+	if(llvm::isa<llvm::ConstantPointerNull>(v)){
+		return llvm::Constant::getNullValue(descTy);
+	}
+	if(!t->get_name().compare("pointer")){
+		t = std::static_pointer_cast<PtrType>(t)->get_type();
+	}
+	int size = std::static_pointer_cast<ArrType>(t)->get_size();
+	llvm::Value* desc = llvm::UndefValue::get(descTy);
+	desc = Builder.CreateInsertValue(desc,
+		Builder.CreateBitCast(v, descTy->getStructElementType(0)), 0);
+	return Builder.CreateInsertValue(desc,
+		c32(size>0 ? size : 0), std::vector<unsigned>{1, 0});
+}
+
 llvm::Type* ArrType::cgen(){
 	if(size>0)
 		return llvm::ArrayType::get(type->cgen(),size);
@@ -116,6 +242,11 @@ llvm::Type* ArrType::cgen(){
 		return llvm::ArrayType::get(type->cgen(),0);
 }
 
+llvm::Type* PackedArrType::cgen(){
+	// 64 elements per word.
+	return llvm::ArrayType::get(i64, size>0 ? ((uint64_t)size+63)/64 : 0);
+}
+
 
 // Code genaration for Const
 //    return llvm::Value*
@@ -300,10 +431,10 @@ llvm::Value* Op::cgen(){
 			if(!leftType->get_name().compare("pointer")){
 				// cast both pointers as i8*
 				leftValue = Builder.CreateBitCast(
-					leftValue,llvm::PointerType::get(i8,0),"lptrcast"
+					data_pointer(leftValue),llvm::PointerType::get(i8,0),"lptrcast"
 				);
 				rightValue = Builder.CreateBitCast(
-					rightValue,llvm::PointerType::get(i8,0),"rptrcast"
+					data_pointer(rightValue),llvm::PointerType::get(i8,0),"rptrcast"
 				);
 			}
 			llvm::Value* v = Builder.CreateICmpNE(leftValue, rightValue, "inetmp");
@@ -330,10 +461,10 @@ llvm::Value* Op::cgen(){
 			if(!leftType->get_name().compare("pointer")){
 				// cast both pointers as i8*
 				leftValue = Builder.CreateBitCast(
-					leftValue,llvm::PointerType::get(i8,0),"lptrcast"
+					data_pointer(leftValue),llvm::PointerType::get(i8,0),"lptrcast"
 				);
 				rightValue = Builder.CreateBitCast(
-					rightValue,llvm::PointerType::get(i8,0),"rptrcast"
+					data_pointer(rightValue),llvm::PointerType::get(i8,0),"rptrcast"
 				);
 			}
 			llvm::Value* v = Builder.CreateICmpEQ(leftValue, rightValue, "ieqtmp");
@@ -440,8 +571,10 @@ llvm::Value* Op::cgen(){
 
 		// if leftValue -> no short circuit; else short circuit
 		//    convert i8 lvalue to i1.
-		llvm::Value* CondV = Builder.CreateTrunc(leftValue, i1, "cond");
+		llvm::Value* CondV = cgen_cond(leftValue);
 		Builder.CreateCondBr(CondV, NoShortCircuitBB, ShortCircuitBB);
+		ct.seal(NoShortCircuitBB);
+		ct.seal(ShortCircuitBB);
 
 		/* no-short-circuit block */
 		ct.setCurrentBB(NoShortCircuitBB);
@@ -460,6 +593,7 @@ llvm::Value* Op::cgen(){
 
 		/* merge block */
 		TheFunction->getBasicBlockList().push_back(MergeBB);
+		ct.seal(MergeBB);
 		ct.setCurrentBB(MergeBB);
 		Builder.SetInsertPoint(MergeBB);
 		llvm::PHINode *PN = Builder.CreatePHI(i8, 2, "andphitmp");
@@ -483,8 +617,10 @@ llvm::Value* Op::cgen(){
 
 		// if leftValue -> short circuit; else no short circuit
 		//    convert i8 lvalue to i1.
-		llvm::Value* CondV = Builder.CreateTrunc(leftValue, i1, "cond");
+		llvm::Value* CondV = cgen_cond(leftValue);
 		Builder.CreateCondBr(CondV, ShortCircuitBB, NoShortCircuitBB);
+		ct.seal(ShortCircuitBB);
+		ct.seal(NoShortCircuitBB);
 
 		/* short-circuit block*/
 		ct.setCurrentBB(ShortCircuitBB);
@@ -504,6 +640,7 @@ llvm::Value* Op::cgen(){
 
 		/* merge block */
 		TheFunction->getBasicBlockList().push_back(MergeBB);
+		ct.seal(MergeBB);
 		ct.setCurrentBB(MergeBB);
 		Builder.SetInsertPoint(MergeBB);
 		llvm::PHINode *PN = Builder.CreatePHI(i8, 2, "orphitmp");
@@ -524,12 +661,15 @@ llvm::Value* Op::cgen(){
 }
 
 llvm::Value* Id::cgen(){
-	bool ref;
-	llvm::Value* var = ct.lookup(name,ref);
-	if(ref){
-		// load once more for reference.
-		var = Builder.CreateLoad(var ,(name+"_ref").c_str());
+	if(constant){
+		// named constant is folded.
+		return constant->cgen();
 	}
+	if(ct.is_ssa(name)){
+		// scalar in SSA form; current definition.
+		return ct.read_var(name, Builder.GetInsertBlock());
+	}
+	llvm::Value* var = ct.lookup(name);
 	return Builder.CreateLoad(var ,name.c_str());
 }
 
@@ -558,13 +698,155 @@ llvm::Value* Dereference::cgen(){
 	return val;
 }
 
+static llvm::Function* external_function(std::string name,
+		llvm::FunctionType* FT){
+	/* declaration of C function 'name' (of runtime or libm); nullptr if it
+	     is not yet declared. a user subprogram or program-level variable
+	     of the same name is internal, so it gives the name up to the C
+	     function. */
+	llvm::GlobalValue* G = TheModule->getNamedValue(name);
+	if(!G) return nullptr;
+	llvm::Function* F = llvm::dyn_cast<llvm::Function>(G);
+	if(F and F->isDeclaration() and F->hasExternalLinkage()
+			and F->getFunctionType()==FT
+			and F->getCallingConv()==llvm::CallingConv::C){
+		return F;
+	}
+	assert(G->hasLocalLinkage());
+	G->setName(name+".user");
+	return nullptr;
+}
+
+static llvm::Function* bounds_error_function(){
+	// 'void pcl_bounds_error(i32 index, i32 size, i32 line)' of the runtime.
+	llvm::FunctionType* FT = llvm::FunctionType::get(
+		voidTy, std::vector<llvm::Type*>{i32, i32, i32}, false);
+	llvm::Function* F = external_function("pcl_bounds_error", FT);
+	if(!F){
+		F = llvm::Function::Create(
+			FT, llvm::Function::ExternalLinkage, "pcl_bounds_error", TheModule.get()
+		);
+		F->addFnAttr(llvm::Attribute::NoReturn);
+		F->addFnAttr(llvm::Attribute::NoUnwind);
+		F->addFnAttr(llvm::Attribute::Cold);
+	}
+	return F;
+}
+
+static void cgen_bounds_check(llvm::Value* index_v, llvm::Value* size, int line){
+	/* '--check-bounds': stop with a runtime error unless
+	     0 <= index < size (a single unsigned compare). */
+	llvm::Function* TheFunction = ct.getFunction();
+	llvm::Value* ok = Builder.CreateICmpULT(index_v, size, "inbounds");
+	if(llvm::isa<llvm::ConstantInt>(ok) and
+			llvm::cast<llvm::ConstantInt>(ok)->isOne()){
+		// constant index, checked at compile time.
+		return;
+	}
+	llvm::BasicBlock *FailBB =
+		llvm::BasicBlock::Create(TheContext, "outofbounds", TheFunction);
+	llvm::BasicBlock *OkBB =
+		llvm::BasicBlock::Create(TheContext, "inbounds", TheFunction);
+	llvm::MDBuilder MDB(TheContext);
+	Builder.CreateCondBr(ok, OkBB, FailBB, MDB.createBranchWeights(1<<20, 1));
+	ct.seal(FailBB);
+	ct.seal(OkBB);
+	Builder.SetInsertPoint(FailBB);
+	Builder.CreateCall(bounds_error_function(),
+		std::vector<llvm::Value*>{index_v, size, c32(line)});
+	Builder.CreateUnreachable();
+	ct.setCurrentBB(OkBB);
+	Builder.SetInsertPoint(OkBB);
+}
+
+static void cgen_index_check(SPtr<ArrType> arrTy, llvm::Value* arr,
+		llvm::Value* index_v, int line){
+	// size of fixed arrays is static; dynamic arrays carry their extents.
+	if(!check_bounds) return;
+	if(arr->getType()->isStructTy()){
+		cgen_bounds_check(index_v, Builder.CreateExtractValue(
+			arr, std::vector<unsigned>{1, 0}, "dim"), line);
+	}
+	else if(arrTy->get_size()>0){
+		cgen_bounds_check(index_v, c32(arrTy->get_size()), line);
+	}
+}
+
+static llvm::Value* cgen_multi_index(llvm::Value* desc, llvm::Value* index_v){
+	/* a[i] of dynamic array a (given by its descriptor): address of
+	     element i if a is 1-D, else descriptor of row (sub-array) i.
+	   offset i*n1*...*nk is computed in i64 without signed wrap, so
+	     chained indices are affine in loop variables and can be
+	     strength-reduced and vectorized. */
+	llvm::Type* extTy = desc->getType()->getStructElementType(1);
+	unsigned rank = extTy->getArrayNumElements();
+	llvm::Value* data = Builder.CreateExtractValue(desc, 0, "data");
+	llvm::Value* offset = Builder.CreateSExt(index_v, i64, "idx");
+	for(unsigned d=1; d<rank; d++){
+		llvm::Value* n = Builder.CreateExtractValue(
+			desc, std::vector<unsigned>{1, d}, "dim"
+		);
+		n = Builder.CreateSExt(n, i64, "dim");
+		offset = Builder.CreateNSWMul(offset, n, "offset");
+	}
+	llvm::Value* ptr = Builder.CreateInBoundsGEP(data, offset, "rowptr");
+	if(rank==1){
+		return ptr;
+	}
+	// sub-array keeps the remaining extents.
+	llvm::Value* sub = llvm::UndefValue::get(llvm::StructType::get(
+		TheContext, std::vector<llvm::Type*>{
+			data->getType(), llvm::ArrayType::get(i32, rank-1)
+		}
+	));
+	sub = Builder.CreateInsertValue(sub, ptr, 0);
+	for(unsigned d=1; d<rank; d++){
+		llvm::Value* n = Builder.CreateExtractValue(
+			desc, std::vector<unsigned>{1, d}, "dim"
+		);
+		sub = Builder.CreateInsertValue(sub, n, std::vector<unsigned>{1, d-1});
+	}
+	return sub;
+}
+
+static llvm::Value* cgen_packed_word(llvm::Value* arr, llvm::Value* index_v,
+		llvm::Value* &bit){
+	/* word of packed array arr (descriptor or pointer to its words)
+	     that holds element i; bit is the position of the element. */
+	llvm::Value* word = Builder.CreateZExt(
+		Builder.CreateLShr(index_v, c32(6)), i64, "word");
+	bit = Builder.CreateZExt(Builder.CreateAnd(index_v, c32(63)), i64, "bit");
+	if(arr->getType()->isStructTy()){
+		return Builder.CreateInBoundsGEP(data_pointer(arr), word, "wordptr");
+	}
+	return Builder.CreateInBoundsGEP(
+		arr, std::vector<llvm::Value*>{c64(0), word}, "wordptr");
+}
+
 llvm::Value* Brackets::cgen(){
 	llvm::Value* arr;
 	llvm::Value* index_v = expr->cgen();
 	SPtr<ArrType> arrTy (std::dynamic_pointer_cast<ArrType>(lvalue->get_type()));
 	arr = lvalue->getAddr();
+	cgen_index_check(arrTy, arr, index_v, location.first_line);
+	if(arrTy->get_rank()>1){
+		// not an element; row or sub-array.
+		return cgen_multi_index(arr, index_v);
+	}
 	llvm::Value* ptr;
-	if(static_cast<llvm::PointerType*>(arr->getType())
+	if(arrTy->is_packed()){
+		llvm::Value* bit;
+		llvm::Value* word =
+			Builder.CreateLoad(cgen_packed_word(arr, index_v, bit), "word");
+		llvm::Value* set = Builder.CreateICmpNE(Builder.CreateAnd(
+			word, Builder.CreateShl(c64(1), bit)), c64(0), "bittmp");
+		return Builder.CreateZExt(set, i8, "booltmp");
+	}
+	if(arr->getType()->isStructTy()){
+		// element of dynamic array.
+		ptr = cgen_multi_index(arr, index_v);
+	}
+	else if(static_cast<llvm::PointerType*>(arr->getType())
 			->getElementType()->isArrayTy()){
 		// GEP needs first a 0 index because arr is pointer (alloca) to array.
 		ptr = Builder.CreateGEP( arr, std::vector<llvm::Value*> {c32(0),index_v});
@@ -595,20 +877,65 @@ llvm::Value* Dereference::getAddr(){
 }
 
 llvm::Value* Id::getAddr(){
-	bool ref;
-	llvm::Value *var = ct.lookup(name, ref);
-	if(ref){
-		// load once more for reference.
-		var = Builder.CreateLoad(var ,(name+"_ref").c_str());
+	if(ct.is_ssa(name)){
+		this->report_error("Cgen::Internal Error: Address of SSA variable.");
+		exit(1);
+	}
+	llvm::Value *var = ct.lookup(name);
+	if(type->is_incomplete() and var->getType()->isPointerTy()){
+		// variable declared 'array of' (no elements).
+		var = cgen_descriptor_of(var, type,
+			std::static_pointer_cast<ArrType>(type)->cgen_descriptor());
 	}
 	return var;
 }
 
+void LValue::cgen_store(llvm::Value* v){
+	Builder.CreateStore(v, getAddr());
+}
+
+void Brackets::cgen_store(llvm::Value* v){
+	if(!is_bit()){
+		LValue::cgen_store(v);
+		return;
+	}
+	// clear the bit of the element, then set it to v (0 or 1).
+	llvm::Value* index_v = expr->cgen();
+	SPtr<ArrType> arrTy (std::dynamic_pointer_cast<ArrType>(lvalue->get_type()));
+	llvm::Value* arr = lvalue->getAddr();
+	cgen_index_check(arrTy, arr, index_v, location.first_line);
+	llvm::Value* bit;
+	llvm::Value* ptr = cgen_packed_word(arr, index_v, bit);
+	llvm::Value* word = Builder.CreateLoad(ptr, "word");
+	word = Builder.CreateAnd(
+		word, Builder.CreateNot(Builder.CreateShl(c64(1), bit)), "word");
+	llvm::Value* set = Builder.CreateShl(Builder.CreateZExt(v, i64), bit, "bittmp");
+	Builder.CreateStore(Builder.CreateOr(word, set, "word"), ptr);
+}
+
+void Id::cgen_store(llvm::Value* v){
+	if(ct.is_ssa(name)){
+		// new definition of scalar in current block.
+		ct.write_var(name, Builder.GetInsertBlock(), v);
+		return;
+	}
+	LValue::cgen_store(v);
+}
+
 llvm::Value* Brackets::getAddr(){
 	llvm::Value* arr;
 	llvm::Value* index_v = expr->cgen();
 	SPtr<ArrType> arrTy (std::dynamic_pointer_cast<ArrType>(lvalue->get_type()));
 	arr = lvalue->getAddr();
+	cgen_index_check(arrTy, arr, index_v, location.first_line);
+	if(arrTy->is_packed()){
+		this->report_error("Cgen::Internal Error: Address of packed array element.");
+		exit(1);
+	}
+	if(arr->getType()->isStructTy()){
+		// element, row or sub-array of dynamic array.
+		return cgen_multi_index(arr, index_v);
+	}
 	llvm::Value* ptr;
 
 	if(static_cast<llvm::PointerType*>(arr->getType())
@@ -646,26 +973,56 @@ void Goto::cgen(){
 	llvm::Function* TheFunction=ct.getFunction();
 	llvm::BasicBlock *BB =
 		llvm::BasicBlock::Create(TheContext, "garb", TheFunction);
+	ct.seal(BB);
 	ct.setCurrentBB(BB);
 	Builder.SetInsertPoint(BB);
 }
 
+static llvm::AllocaInst* cgen_entry_alloca(llvm::Type* t, std::string name){
+	// temporary in the entry block, so that loops reuse one stack slot.
+	llvm::BasicBlock &entry = ct.getFunction()->getEntryBlock();
+	llvm::IRBuilderBase::InsertPoint IP = Builder.saveIP();
+	Builder.SetInsertPoint(&entry, entry.begin());
+	llvm::AllocaInst* alloca = Builder.CreateAlloca(t, nullptr, name);
+	Builder.restoreIP(IP);
+	return alloca;
+}
+
+static void cgen_copy_array(llvm::Value* dst, llvm::Value* src, llvm::Type* t){
+	/* whole array copy as a single memcpy of known size
+	     (instead of a first-class aggregate load and store). */
+	const llvm::DataLayout &DL = TheModule->getDataLayout();
+	llvm::Align align = DL.getABITypeAlign(t);
+	dst = Builder.CreateBitCast(dst, llvm::PointerType::get(t, 0));
+	src = Builder.CreateBitCast(src, llvm::PointerType::get(t, 0));
+	Builder.CreateMemCpy(dst, align, src, align, DL.getTypeAllocSize(t));
+}
+
 void Let::cgen(){
+	llvm::Type* tp = lvalue->get_type()->cgen();
+	if(tp->isArrayTy() and expr->isLValue()){
+		// array assignment.
+		llvm::Value* src = static_cast<LValue*>(expr)->getAddr();
+		cgen_copy_array(lvalue->getAddr(), src, tp);
+		return;
+	}
 	llvm::Value *e=expr->cgen();
 	if(different_types and is_right_int){ //right is integer and left is real
 		// first convert integer to real
 		e = Builder.CreateSIToFP(e,doubleTy,"transtmp");
 	}
 
-	llvm::Type* tp = lvalue->get_type()->cgen();
 	if(tp->isPointerTy()){
 		// pointer value needs to be bitcast
 		//   in case of nil (i8*) to lvalue type.
 		e = Builder.CreateBitCast(e, tp);
 	}
+	else if(tp->isStructTy()){
+		// nil or pointer to fixed array; to dynamic array.
+		e = cgen_descriptor_of(e, expr->get_type(), tp);
+	}
 
-	llvm::Value *addr=lvalue->getAddr();
-	Builder.CreateStore(e, addr);
+	lvalue->cgen_store(e);
 }
 
 void If::cgen(){
@@ -679,9 +1036,11 @@ void If::cgen(){
 	llvm::BasicBlock *MergeBB =llvm::BasicBlock::Create(TheContext, "ifcont");
 
 	// condition branch
-	llvm::Value* CondV = Builder.CreateTrunc(expr->cgen(), i1, "cond");
+	llvm::Value* CondV = cgen_cond(expr->cgen());
 
 	Builder.CreateCondBr(CondV, ThenBB, ElseBB);
+	ct.seal(ThenBB);
+	ct.seal(ElseBB);
 
 	/* then block */
 	ct.setCurrentBB(ThenBB);
@@ -698,6 +1057,7 @@ void If::cgen(){
 
 	/* merge block */
 	TheFunction->getBasicBlockList().push_back(MergeBB);
+	ct.seal(MergeBB);
 	ct.setCurrentBB(MergeBB);
 	Builder.SetInsertPoint(MergeBB);
 }
@@ -719,8 +1079,10 @@ void While::cgen(){
 	ct.setCurrentBB(BeforeBB);
 	Builder.SetInsertPoint(BeforeBB);
 	// condition branch
-	llvm::Value* CondV = Builder.CreateTrunc(expr->cgen(), i1, "cond");
+	llvm::Value* CondV = cgen_cond(expr->cgen());
 	Builder.CreateCondBr(CondV, LoopBB, AfterBB);
+	ct.seal(LoopBB);
+	ct.seal(AfterBB);
 
 	/* loop block */
 	TheFunction->getBasicBlockList().push_back(LoopBB);
@@ -728,9 +1090,123 @@ void While::cgen(){
 	Builder.SetInsertPoint(LoopBB);
 	stmt->cgen();
 	Builder.CreateBr(BeforeBB);
+	// back edge is known; loop header can be completed.
+	ct.seal(BeforeBB);
+
+	/* after block */
+	TheFunction->getBasicBlockList().push_back(AfterBB);
+	ct.setCurrentBB(AfterBB);
+	Builder.SetInsertPoint(AfterBB);
+}
+
+void For::cgen(){
+	/* bounds are evaluated once; the loop runs on an induction
+	     variable of its own (a phi, even if the counter is captured or
+	     assigned in the body), which is stored to the counter on every
+	     iteration. The exit test compares against the last value, so
+	     the trip count is known and 'to maxint' does not overflow. */
+	llvm::Function* TheFunction = ct.getFunction();
+	llvm::Value* first = from->cgen();
+	llvm::Value* last = to->cgen();
+
+	llvm::BasicBlock *LoopBB =
+		llvm::BasicBlock::Create(TheContext, "for", TheFunction);
+	llvm::BasicBlock *NextBB =
+		llvm::BasicBlock::Create(TheContext, "fornext");
+	llvm::BasicBlock *AfterBB =
+		llvm::BasicBlock::Create(TheContext, "forend");
+
+	// guard; body runs at least once past it.
+	llvm::Value* CondV = down ?
+		Builder.CreateICmpSGE(first, last, "forcond") :
+		Builder.CreateICmpSLE(first, last, "forcond");
+	llvm::BasicBlock* PreheaderBB = Builder.GetInsertBlock();
+	Builder.CreateCondBr(CondV, LoopBB, AfterBB);
+
+	/* loop block */
+	ct.setCurrentBB(LoopBB);
+	Builder.SetInsertPoint(LoopBB);
+	llvm::PHINode* iv = Builder.CreatePHI(i32, 2, "iv");
+	iv->addIncoming(first, PreheaderBB);
+	counter->cgen_store(iv);
+	stmt->cgen();
+	Builder.CreateBr(NextBB);
+
+	/* latch */
+	TheFunction->getBasicBlockList().push_back(NextBB);
+	ct.seal(NextBB);
+	ct.setCurrentBB(NextBB);
+	Builder.SetInsertPoint(NextBB);
+	llvm::Value* done = Builder.CreateICmpEQ(iv, last, "fordone");
+	llvm::Value* next = down ?
+		Builder.CreateNSWSub(iv, c32(1), "ivnext") :
+		Builder.CreateNSWAdd(iv, c32(1), "ivnext");
+	llvm::BranchInst* BackBr = Builder.CreateCondBr(done, AfterBB, LoopBB);
+	iv->addIncoming(next, NextBB);
+	// self-referential loop id; a counted loop always terminates.
+	llvm::MDNode* progress = llvm::MDNode::get(TheContext,
+		llvm::MDString::get(TheContext, "llvm.loop.mustprogress"));
+	llvm::MDNode* loopID = llvm::MDNode::getDistinct(TheContext,
+		std::vector<llvm::Metadata*>{nullptr, progress});
+	loopID->replaceOperandWith(0, loopID);
+	BackBr->setMetadata(llvm::LLVMContext::MD_loop, loopID);
+	// back edge is known; loop header can be completed.
+	ct.seal(LoopBB);
 
 	/* after block */
 	TheFunction->getBasicBlockList().push_back(AfterBB);
+	ct.seal(AfterBB);
+	ct.setCurrentBB(AfterBB);
+	Builder.SetInsertPoint(AfterBB);
+}
+
+void Case::cgen(){
+	/* a single switch; LLVM picks a jump table, bit tests or a
+	     binary search for it. */
+	llvm::Function* TheFunction = ct.getFunction();
+	llvm::Value* v = expr->cgen();
+	llvm::BasicBlock *DefaultBB =
+		llvm::BasicBlock::Create(TheContext, "casedefault");
+	llvm::BasicBlock *AfterBB =
+		llvm::BasicBlock::Create(TheContext, "caseend");
+	llvm::SwitchInst* Switch = Builder.CreateSwitch(v, DefaultBB, arms->size());
+
+	// all edges of the switch first; then each arm block has its
+	//   predecessor and can be sealed.
+	std::vector<llvm::BasicBlock*> ArmBBs;
+	for(uint i=0; i<arms->size(); i++){
+		CaseArm* arm = (*arms)[i];
+		llvm::BasicBlock* ArmBB = llvm::BasicBlock::Create(TheContext, "case");
+		for(uint j=0; j<arm->labels->size(); j++){
+			llvm::ConstantInt* c =
+				llvm::cast<llvm::ConstantInt>((*arm->labels)[j]->cgen());
+			// duplicate labels are rejected in sem.
+			assert(Switch->findCaseValue(c)==Switch->case_default());
+			Switch->addCase(c, ArmBB);
+		}
+		ArmBBs.push_back(ArmBB);
+	}
+
+	for(uint i=0; i<arms->size(); i++){
+		TheFunction->getBasicBlockList().push_back(ArmBBs[i]);
+		ct.seal(ArmBBs[i]);
+		ct.setCurrentBB(ArmBBs[i]);
+		Builder.SetInsertPoint(ArmBBs[i]);
+		(*arms)[i]->stmt->cgen();
+		Builder.CreateBr(AfterBB);
+	}
+
+	/* else */
+	TheFunction->getBasicBlockList().push_back(DefaultBB);
+	ct.seal(DefaultBB);
+	ct.setCurrentBB(DefaultBB);
+	Builder.SetInsertPoint(DefaultBB);
+	if(other) other->cgen();
+	Builder.CreateBr(AfterBB);
+
+	/* merge block */
+	TheFunction->getBasicBlockList().push_back(AfterBB);
+	ct.seal(AfterBB);
 	ct.setCurrentBB(AfterBB);
 	Builder.SetInsertPoint(AfterBB);
 }
@@ -739,7 +1215,52 @@ void New::cgen(){
 	llvm::DataLayout* DL = new llvm::DataLayout(&(*TheModule));
 	// get size of type to malloc
 	llvm::Type* ptrTy = lvalue->get_type()->cgen();
+	if(ptrTy->isStructTy()){
+		/* dynamic array; descriptor with data and extents */
+		std::vector<llvm::Value*> extents;
+		if(dims){
+			for(unsigned i=0; i<dims->size(); i++){
+				extents.push_back((*dims)[i]->cgen());
+			}
+		}
+		else{
+			// 'new' of an 'array of' without size has no elements.
+			extents.push_back(expr ? expr->cgen() : c32(0));
+		}
+		llvm::Type* dataTy = ptrTy->getStructElementType(0);
+		TSPtr arrTy = std::static_pointer_cast<PtrType>(lvalue->get_type())
+			->get_type();
+		bool packed = std::static_pointer_cast<ArrType>(arrTy)->is_packed();
+		llvm::Value* desc = llvm::UndefValue::get(ptrTy);
+		// total size is product of extents and size of element.
+		llvm::Value* AllocSize =
+			c64(DL->getTypeAllocSize(dataTy->getPointerElementType()));
+		for(unsigned i=0; i<extents.size(); i++){
+			llvm::Value* n = extents[i];
+			desc = Builder.CreateInsertValue(desc, n, std::vector<unsigned>{1, i});
+			llvm::Value* cast64 = Builder.CreateZExt(n, i64, "cast");
+			if(packed){
+				// number of words holding n bits.
+				cast64 = Builder.CreateLShr(
+					Builder.CreateAdd(cast64, c64(63)), c64(6), "words");
+			}
+			AllocSize = Builder.CreateMul(cast64, AllocSize);
+		}
+		llvm::Value *ptr = Builder.CreateCall(
+			TheModule->getFunction(gc_heap ? "pcl_gc_alloc" : "pcl_alloc_array"),
+			std::vector<llvm::Value*> {AllocSize});
+		if(!gc_heap){
+			Builder.CreateAlignmentAssumption(*DL, ptr, 64);
+		}
+		ptr = Builder.CreateBitCast(ptr, dataTy);
+		desc = Builder.CreateInsertValue(desc, ptr, 0);
+		lvalue->cgen_store(desc);
+		return;
+	}
 	llvm::Type* ty = ptrTy->getPointerElementType();
+	// any array, with or without '[n]', is served by the array allocator;
+	//   dispose picks the same one from the pointee type.
+	bool array = ty->isArrayTy();
 	llvm::Value *AllocSize;
 	if(expr){
 		/* array */
@@ -754,39 +1275,74 @@ void New::cgen(){
 		/* simple pointer */
 		AllocSize = c64(DL->getTypeAllocSize(ty));
 	}
+	// size of a single object is known again at dispose, so it is
+	//   served by the pool allocator.
+	const char* alloc_name = array ? "pcl_alloc_array" : "pcl_alloc";
+	if(gc_heap){
+		alloc_name = "pcl_gc_alloc";
+	}
 	llvm::Value *ptr = Builder.CreateCall(
-		TheModule->getFunction("malloc"), std::vector<llvm::Value*> {AllocSize});
+		TheModule->getFunction(alloc_name),
+		std::vector<llvm::Value*> {AllocSize});
+	if(array and !gc_heap){
+		// arrays are cache line aligned; lets loops use aligned accesses.
+		Builder.CreateAlignmentAssumption(*DL, ptr, 64);
+	}
 	// cast malloc pointer to requested type.
 	ptr = Builder.CreateBitCast(ptr, ptrTy);
-	// store pointer value to lvalue address.
-	Builder.CreateStore(ptr,lvalue->getAddr());
+	// store pointer value to lvalue.
+	lvalue->cgen_store(ptr);
+}
+
+static void cgen_free_array(llvm::Value* ptr){
+	// bitcast ptr to i8* to pass as argument to "pcl_free_array" function.
+	ptr = Builder.CreateBitCast(data_pointer(ptr), llvm::PointerType::get(i8, 0));
+	// call "pcl_free_array" function from TheModule.
+	Builder.CreateCall(
+		TheModule->getFunction("pcl_free_array"),
+		std::vector<llvm::Value*> {ptr}
+	);
 }
 
 void Dispose::cgen(){
-	llvm::Value *ptr = Builder.CreateLoad(lvalue->getAddr(),"disptmp");
+	const llvm::DataLayout &DL = TheModule->getDataLayout();
 	llvm::Type *t = lvalue->get_type()->cgen();
-	// bitcast ptr to i8* to pass as argument to "free" function.
+	llvm::Value *nil = llvm::Constant::getNullValue(t);
+	if(gc_heap){
+		// the collector frees the object once it is unreachable.
+		lvalue->cgen_store(nil);
+		return;
+	}
+	llvm::Value *ptr = lvalue->cgen();
+	if(t->isStructTy() or t->getPointerElementType()->isArrayTy()){
+		// arrays are always allocated as arrays, whatever form of new made them.
+		cgen_free_array(ptr);
+		lvalue->cgen_store(nil);
+		return;
+	}
+	// bitcast ptr to i8* to pass as argument to "pcl_free" function.
 	ptr = Builder.CreateBitCast(ptr, llvm::PointerType::get(i8, 0));
-	// call "free" function from TheModule.
+	// object size (as in New) tells the pool allocator its size class.
+	llvm::Value *size = c64(DL.getTypeAllocSize(t->getPointerElementType()));
+	// call "pcl_free" function from TheModule.
 	Builder.CreateCall(
-		TheModule->getFunction("free"),
-		std::vector<llvm::Value*> {ptr}
+		TheModule->getFunction("pcl_free"),
+		std::vector<llvm::Value*> {ptr, size}
 	);
 	// store nil in free'd pointer. nil is created with type of ptr.
-	llvm::Value *nil = llvm::Constant::getNullValue(t);
-	Builder.CreateStore(nil, lvalue->getAddr());
+	lvalue->cgen_store(nil);
 }
 
 void DisposeArr::cgen(){
-	llvm::Value *ptr = Builder.CreateLoad(lvalue->getAddr(),"disptmp");
 	llvm::Type *t = lvalue->get_type()->cgen();
-	// bitcast ptr to i8* to pass as argument to "free" function.
-	ptr = Builder.CreateBitCast(ptr, llvm::PointerType::get(i8, 0));
-	// call "free" function from TheModule.
-	Builder.CreateCall(TheModule->getFunction("free"), std::vector<llvm::Value*> {ptr} );
-	// store nil in free'd pointer. nil is created with type of ptr.
 	llvm::Value *nil = llvm::Constant::getNullValue(t);
-	Builder.CreateStore(nil, lvalue->getAddr());
+	if(gc_heap){
+		lvalue->cgen_store(nil);
+		return;
+	}
+	cgen_free_array(lvalue->cgen());
+	// store nil in free'd pointer. nil is created with type of ptr.
+	lvalue->cgen_store(nil);
 }
 
 void StmtList::cgen(){
@@ -803,11 +1359,83 @@ void DeclList::cgen(){
 	}
 }
 
+llvm::Constant* Initializer::cgen(TSPtr t){
+	llvm::Type* ty = t->cgen();
+	if(!ty->isArrayTy()){
+		llvm::Constant* c = llvm::cast<llvm::Constant>(value->cgen());
+		if(c->getType()!=ty){
+			// integer element of array of real.
+			c = llvm::ConstantExpr::getSIToFP(c, ty);
+		}
+		return c;
+	}
+	SPtr<ArrType> arr = std::static_pointer_cast<ArrType>(t);
+	unsigned n = ty->getArrayNumElements();
+	std::vector<llvm::Constant*> elems;
+	if(arr->is_packed()){
+		// bit i of word i/64.
+		std::vector<uint64_t> words(n, 0);
+		for(uint i=0; i<items->size(); i++){
+			if(!llvm::cast<llvm::ConstantInt>((*items)[i]->cgen(arr->get_type()))
+					->isZero()){
+				words[i/64] |= 1ULL<<(i%64);
+			}
+		}
+		for(uint64_t w: words){
+			elems.push_back(llvm::ConstantInt::get(i64, w));
+		}
+	}
+	else if(is_string){
+		for(char c: str){
+			elems.push_back(llvm::ConstantInt::get(i8, c));
+		}
+	}
+	else{
+		for(uint i=0; i<items->size(); i++){
+			elems.push_back((*items)[i]->cgen(arr->get_type()));
+		}
+	}
+	// elements without initializer are zero.
+	while(elems.size()<n){
+		elems.push_back(llvm::Constant::getNullValue(ty->getArrayElementType()));
+	}
+	return llvm::ConstantArray::get(llvm::cast<llvm::ArrayType>(ty), elems);
+}
+
 void VarDecl::cgen(){
+	if(ct.isGlobalScope()){
+		// program-level var is an internal module global; nested
+		//   subprograms access it directly instead of as outer argument.
+		//   Its initializer (if any) is the initial content of the global,
+		//   so no code runs for it.
+		llvm::Type* ty = type->cgen();
+		llvm::GlobalVariable* global = new llvm::GlobalVariable(
+			*TheModule, ty, false, llvm::GlobalValue::InternalLinkage,
+			init ? init->cgen(type) : llvm::Constant::getNullValue(ty), id
+		);
+		// insert global to cgen table.
+		ct.insert_global(id, global);
+		return;
+	}
+	llvm::Type* ty = type->cgen();
+	if(!ty->isArrayTy() and !ct.is_addr_taken(id)){
+		// scalar is kept in SSA form; no memory.
+		ct.insert_ssa(id, ty);
+		return;
+	}
 	// allocate var according to type.
-	llvm::AllocaInst* alloca = Builder.CreateAlloca(type->cgen(), nullptr, id);
+	llvm::AllocaInst* alloca = Builder.CreateAlloca(ty, nullptr, id);
 	// insert alloca to cgen table.
 	ct.insert(id, alloca);
+	if(init){
+		// copy of a read-only table on every call (like a string literal).
+		llvm::GlobalVariable* table = new llvm::GlobalVariable(
+			*TheModule, ty, true, llvm::GlobalValue::PrivateLinkage,
+			init->cgen(type), id+".init"
+		);
+		table->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+		cgen_copy_array(alloca, table, ty);
+	}
 }
 
 void LabelDecl::cgen(){
@@ -831,6 +1459,273 @@ void Body::cgen(){
 	// body of library subprogram is located in library implementation file.
 }
 
+// largest objects and arrays moved from the heap to the stack.
+static const uint64_t stack_object_max = 256;
+static const uint64_t stack_array_max = 4096;
+
+static bool in_cycle(llvm::BasicBlock* BB){
+	// BB can be executed more than once per call.
+	std::vector<llvm::BasicBlock*> work(llvm::succ_begin(BB), llvm::succ_end(BB));
+	std::set<llvm::BasicBlock*> seen;
+	while(!work.empty()){
+		llvm::BasicBlock* B = work.back();
+		work.pop_back();
+		if(B==BB) return true;
+		if(!seen.insert(B).second) continue;
+		work.insert(work.end(), llvm::succ_begin(B), llvm::succ_end(B));
+	}
+	return false;
+}
+
+static bool escapes(llvm::CallInst* alloc, std::vector<llvm::CallInst*> &frees){
+	/* whether the object may outlive the call: its address is stored
+	     to memory, passed to a call or returned, or it is mixed (phi,
+	     select) with other pointers. Collects the dispose calls. */
+	std::vector<llvm::Value*> work{alloc};
+	std::set<llvm::Value*> derived{alloc};
+	std::vector<llvm::Instruction*> merges;
+	while(!work.empty()){
+		llvm::Value* V = work.back();
+		work.pop_back();
+		for(auto U : V->users()){
+			llvm::Instruction* I = llvm::cast<llvm::Instruction>(U);
+			if(llvm::isa<llvm::BitCastInst>(I) or llvm::isa<llvm::GetElementPtrInst>(I)
+					or llvm::isa<llvm::PHINode>(I) or llvm::isa<llvm::SelectInst>(I)){
+				if(llvm::isa<llvm::PHINode>(I) or llvm::isa<llvm::SelectInst>(I)){
+					merges.push_back(I);
+				}
+				if(derived.insert(I).second) work.push_back(I);
+			}
+			else if(llvm::isa<llvm::InsertValueInst>(I)){
+				// descriptor of dynamic array.
+				if(derived.insert(I).second) work.push_back(I);
+			}
+			else if(llvm::ExtractValueInst* ev =
+					llvm::dyn_cast<llvm::ExtractValueInst>(I)){
+				// data pointer of descriptor (extents are only integers).
+				if(ev->getIndices()[0]==0 and derived.insert(I).second){
+					work.push_back(I);
+				}
+			}
+			else if(llvm::isa<llvm::LoadInst>(I) or llvm::isa<llvm::ICmpInst>(I)){
+				continue;
+			}
+			else if(llvm::StoreInst* st = llvm::dyn_cast<llvm::StoreInst>(I)){
+				// storing through the pointer is fine; storing it is not.
+				if(st->getValueOperand()==V) return true;
+			}
+			else if(llvm::CallInst* call = llvm::dyn_cast<llvm::CallInst>(I)){
+				llvm::Function* callee = call->getCalledFunction();
+				if(callee and callee->getIntrinsicID()==llvm::Intrinsic::assume){
+					// alignment assumption on the new array.
+					continue;
+				}
+				if(!callee or (callee->getName()!="pcl_free"
+						and callee->getName()!="pcl_free_array")){
+					return true;
+				}
+				frees.push_back(call);
+			}
+			else{
+				return true;
+			}
+		}
+	}
+	for(auto I : merges){
+		// every merged pointer must be this object (or nil).
+		unsigned first = llvm::isa<llvm::SelectInst>(I) ? 1 : 0;
+		for(unsigned i=first; i<I->getNumOperands(); i++){
+			llvm::Value* op = I->getOperand(i);
+			if(!derived.count(op) and !(llvm::isa<llvm::Constant>(op) and
+					llvm::cast<llvm::Constant>(op)->isNullValue())){
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+static void cgen_remove_bounds_checks(llvm::Function* F){
+	/* bounds checks that hold on every execution are dropped; scalar
+	     evolution bounds the (SSA) induction variables of while loops
+	     by their loop conditions and by the conditions that guard
+	     the check. */
+	llvm::Function* error_f = TheModule->getFunction("pcl_bounds_error");
+	if(!error_f) return;
+	llvm::DominatorTree DT(*F);
+	// every use of an extent reads the descriptor again; one value per
+	//   extent lets conditions on it ('i < length(a)') bound the checks.
+	std::map<std::pair<llvm::Value*, unsigned>,
+		std::vector<llvm::ExtractValueInst*>> extents;
+	for(auto &BB : *F){
+		for(auto &I : BB){
+			llvm::ExtractValueInst* ev = llvm::dyn_cast<llvm::ExtractValueInst>(&I);
+			if(!ev or ev->getNumIndices()!=2 or ev->getIndices()[0]!=1) continue;
+			extents[{ev->getAggregateOperand(), ev->getIndices()[1]}].push_back(ev);
+		}
+	}
+	for(auto &e : extents){
+		std::vector<llvm::ExtractValueInst*> &same = e.second;
+		for(auto ev : same){
+			for(auto dom : same){
+				if(dom!=ev and !dom->use_empty() and DT.dominates(dom, ev)){
+					ev->replaceAllUsesWith(dom);
+					break;
+				}
+			}
+		}
+		for(auto ev : same){
+			if(ev->use_empty()) ev->eraseFromParent();
+		}
+	}
+	llvm::LoopInfo LI(DT);
+	llvm::AssumptionCache AC(*F);
+	llvm::TargetLibraryInfoImpl TLII(llvm::Triple(TheModule->getTargetTriple()));
+	llvm::TargetLibraryInfo TLI(TLII);
+	llvm::ScalarEvolution SE(*F, TLI, AC, DT, LI);
+	std::vector<llvm::BranchInst*> proven;
+	for(auto &BB : *F){
+		llvm::BranchInst* br = llvm::dyn_cast<llvm::BranchInst>(BB.getTerminator());
+		if(!br or !br->isConditional()) continue;
+		llvm::CallInst* fail =
+			llvm::dyn_cast<llvm::CallInst>(&br->getSuccessor(1)->front());
+		if(!fail or fail->getCalledFunction()!=error_f) continue;
+		llvm::ICmpInst* cmp = llvm::dyn_cast<llvm::ICmpInst>(br->getCondition());
+		if(!cmp) continue;
+		const llvm::SCEV* index = SE.getSCEV(cmp->getOperand(0));
+		const llvm::SCEV* size = SE.getSCEV(cmp->getOperand(1));
+		auto holds = [&](llvm::ICmpInst::Predicate pred,
+				const llvm::SCEV* lhs, const llvm::SCEV* rhs){
+			return SE.isKnownPredicate(pred, lhs, rhs) or
+				SE.isBasicBlockEntryGuardedByCond(&BB, pred, lhs, rhs);
+		};
+		// counting down: 0 <= index < size as signed integers.
+		if(holds(llvm::ICmpInst::ICMP_ULT, index, size) or
+				(holds(llvm::ICmpInst::ICMP_SGE, index, SE.getZero(index->getType()))
+				and holds(llvm::ICmpInst::ICMP_SLT, index, size))){
+			proven.push_back(br);
+		}
+	}
+	for(auto br : proven){
+		llvm::BasicBlock* FailBB = br->getSuccessor(1);
+		llvm::Instruction* cmp = llvm::cast<llvm::Instruction>(br->getCondition());
+		llvm::BranchInst::Create(br->getSuccessor(0), br);
+		br->eraseFromParent();
+		cmp->eraseFromParent();
+		// error block was reached only from this check.
+		FailBB->eraseFromParent();
+	}
+}
+
+static void cgen_stack_objects(llvm::Function* F){
+	/* 'new' of small objects (and arrays of small constant size) that
+	     never escape the subprogram become stack allocations; their
+	     dispose calls are dropped. */
+	std::vector<llvm::CallInst*> allocs;
+	for(auto &BB : *F){
+		for(auto &I : BB){
+			llvm::CallInst* call = llvm::dyn_cast<llvm::CallInst>(&I);
+			if(!call or !call->getCalledFunction()) continue;
+			std::string name = call->getCalledFunction()->getName().str();
+			if(name!="pcl_alloc" and name!="pcl_alloc_array"
+					and name!="pcl_gc_alloc") continue;
+			llvm::ConstantInt* size =
+				llvm::dyn_cast<llvm::ConstantInt>(call->getArgOperand(0));
+			uint64_t max =
+				name=="pcl_alloc_array" ? stack_array_max : stack_object_max;
+			// one stack slot can serve only one live object.
+			if(size and size->getZExtValue()<=max and !in_cycle(&BB)){
+				allocs.push_back(call);
+			}
+		}
+	}
+	llvm::BasicBlock &entry = F->getEntryBlock();
+	for(auto alloc : allocs){
+		std::vector<llvm::CallInst*> frees;
+		if(escapes(alloc, frees)) continue;
+		uint64_t size =
+			llvm::cast<llvm::ConstantInt>(alloc->getArgOperand(0))->getZExtValue();
+		Builder.SetInsertPoint(&entry, entry.begin());
+		llvm::AllocaInst* slot = Builder.CreateAlloca(
+			llvm::ArrayType::get(i8, size), nullptr, "newtmp"
+		);
+		// keep the alignment the runtime allocators guarantee.
+		llvm::StringRef name = alloc->getCalledFunction()->getName();
+		slot->setAlignment(llvm::Align(
+			name=="pcl_alloc_array" ? 64 : name=="pcl_gc_alloc" ? 16 : 8
+		));
+		Builder.SetInsertPoint(alloc);
+		llvm::Value* ptr = Builder.CreateBitCast(
+			slot, llvm::PointerType::get(i8, 0), "newtmp"
+		);
+		alloc->replaceAllUsesWith(ptr);
+		alloc->eraseFromParent();
+		for(auto call : frees){
+			call->eraseFromParent();
+		}
+	}
+}
+
+static void cgen_tail_calls(llvm::Function* F, llvm::BasicBlock* ExitBB){
+	/* mark calls whose value is returned at once as 'musttail', so that
+	     (mutual) recursion runs in constant stack space. */
+	// a tail callee reuses the frame, so no argument may point into it.
+	for(auto &BB : *F){
+		for(auto &I : BB){
+			if(llvm::isa<llvm::AllocaInst>(I)) return;
+		}
+	}
+	std::vector<llvm::CallInst*> tails;
+	for(auto &BB : *F){
+		llvm::BranchInst* br =
+			llvm::dyn_cast<llvm::BranchInst>(BB.getTerminator());
+		if(!br or br->isConditional()) continue;
+		llvm::CallInst* call =
+			llvm::dyn_cast_or_null<llvm::CallInst>(br->getPrevNode());
+		if(!call) continue;
+		llvm::Function* callee = call->getCalledFunction();
+		// prototype and calling convention must match the caller.
+		if(!callee or callee->getFunctionType()!=F->getFunctionType()
+				or callee->getCallingConv()!=F->getCallingConv()) continue;
+		// follow blocks holding only phis and a branch (e.g. if/while
+		//   continuations) to exit.
+		std::vector<llvm::BasicBlock*> path{&BB};
+		llvm::BasicBlock* succ = br->getSuccessor(0);
+		while(succ!=ExitBB and succ->getFirstNonPHI()==succ->getTerminator()){
+			llvm::BranchInst* next =
+				llvm::dyn_cast<llvm::BranchInst>(succ->getTerminator());
+			if(!next or next->isConditional()) break;
+			path.push_back(succ);
+			succ = next->getSuccessor(0);
+		}
+		if(succ!=ExitBB) continue;
+		if(!F->getReturnType()->isVoidTy()){
+			// result on this path must be the value of the call.
+			llvm::Value* res = ExitBB->getTerminator()->getOperand(0);
+			for(auto pred=path.rbegin(); pred!=path.rend(); ++pred){
+				llvm::PHINode* phi = llvm::dyn_cast<llvm::PHINode>(res);
+				if(phi and phi->getParent()==succ){
+					res = phi->getIncomingValueForBlock(*pred);
+				}
+				succ = *pred;
+			}
+			if(res!=call) continue;
+		}
+		tails.push_back(call);
+	}
+	for(auto call : tails){
+		// return directly after the call instead of going through exit.
+		llvm::BasicBlock* BB = call->getParent();
+		llvm::Instruction* br = BB->getTerminator();
+		br->getSuccessor(0)->removePredecessor(BB);
+		br->eraseFromParent();
+		Builder.SetInsertPoint(BB);
+		if(F->getReturnType()->isVoidTy()) Builder.CreateRetVoid();
+		else Builder.CreateRet(call);
+		call->setTailCallKind(llvm::CallInst::TCK_MustTail);
+	}
+}
+
 void Procedure::cgen(){
 
 	llvm::FunctionType* FT = static_cast<llvm::FunctionType*>(type->cgen());
@@ -847,10 +1742,22 @@ void Procedure::cgen(){
 		// function is already created (as a header).
 		F=callee;
 	}
-	else{
+	else if(body->isLibrary()){
+		// built-in; defined in library implementation file.
 		F = llvm::Function::Create(
 			FT, llvm::Function::ExternalLinkage, call_name, TheModule.get()
 		);
+		type->cgen_attributes(F);
+		// insert function to current scope of cgen table.
+		ct.insert_function(id, F);
+	}
+	else{
+		// user subprogram is only called from this module.
+		F = llvm::Function::Create(
+			FT, llvm::Function::InternalLinkage, call_name, TheModule.get()
+		);
+		F->setCallingConv(llvm::CallingConv::Fast);
+		type->cgen_attributes(F);
 		// insert function to current scope of cgen table.
 		ct.insert_function(id, F);
 	}
@@ -859,12 +1766,14 @@ void Procedure::cgen(){
 
 	ct.openScope(F);
 	// open new scope for subprogram.
+	ct.set_addr_taken(type->get_addr_taken());
 	std::vector<std::string> formal_vars = type->get_formal_vars();
 	std::vector<std::string> outer_vars = type->get_outer_vars();
 	std::vector<bool> by_ref = type->get_by_ref();
 
 	// create function entry block
 	llvm::BasicBlock *BB = llvm::BasicBlock::Create(TheContext, "entry", F);
+	ct.seal(BB);
 	ct.setCurrentBB(BB);
 	// create function exit block
 	llvm::BasicBlock *ExitBB = llvm::BasicBlock::Create(TheContext,"exit");
@@ -873,12 +1782,17 @@ void Procedure::cgen(){
 	Builder.SetInsertPoint(BB);
 	llvm::Type* ret_type = F->getReturnType();
 	bool isFunction=false;
-	llvm::AllocaInst* result_alloca;
+	llvm::AllocaInst* result_alloca = nullptr;
 	if(!ret_type->isVoidTy()){
 		isFunction=true;
-		// if subprogram is function, create alloca for result.
-		result_alloca = Builder.CreateAlloca(ret_type, nullptr, "result");
-		ct.insert("result", result_alloca);
+		if(ct.is_addr_taken("result")){
+			// if subprogram is function, create alloca for result.
+			result_alloca = Builder.CreateAlloca(ret_type, nullptr, "result");
+			ct.insert("result", result_alloca);
+		}
+		else{
+			ct.insert_ssa("result", ret_type);
+		}
 	}
 
 	unsigned Idx_formal=0;
@@ -887,53 +1801,83 @@ void Procedure::cgen(){
 	unsigned os=outer_vars.size();
 
 	for(auto &Arg : F->args()){
-		llvm::AllocaInst* alloca = nullptr;
+		std::string name;
+		bool ref;
+		unsigned idx = Idx_formal+Idx_outer;
 		if(Idx_formal<fs){
 			/* formal argument */
-
-			// set name.
-			Arg.setName(formal_vars[Idx_formal]);
-			// allocate space according to type.
-			alloca = Builder.CreateAlloca(Arg.getType(), nullptr, Arg.getName());
-			// insert alloca in cgen table.
-			ct.insert(Arg.getName(), alloca, by_ref[Idx_formal]);
+			name = formal_vars[Idx_formal];
+			ref = by_ref[Idx_formal];
 			Idx_formal++;
 		}
 		else if(Idx_outer<os){
 			/* outer argument (from outer scope). */
-
-			// set name.
-			Arg.setName(outer_vars[Idx_outer++]);
-			// allocate space according to type.
-			alloca = Builder.CreateAlloca(Arg.getType(), nullptr, Arg.getName());
-			// insert alloca in cgen table.
-			//  true because all outer arguments are passed by reference.
-			ct.insert(Arg.getName(), alloca, true);
+			name = outer_vars[Idx_outer++];
+			// all outer arguments are passed by reference.
+			ref = true;
 		}
 		else{
 			this->report_error("Code generation error:"
 			" number of arguments in function");
 		}
-		// Store the initial value into the alloca.
-		Builder.CreateStore(&Arg, alloca);
+		// set name.
+		Arg.setName(name);
+		if(ref or type->shares_array(idx)){
+			// argument is the address of the variable itself
+			//   (or of an array that is only read).
+			ct.insert(name, &Arg);
+		}
+		else if(type->by_pointer(idx)){
+			// by-value array that is written; local copy.
+			llvm::Type* arrTy = Arg.getType()->getPointerElementType();
+			llvm::AllocaInst* alloca =
+				Builder.CreateAlloca(arrTy, nullptr, name);
+			ct.insert(name, alloca);
+			cgen_copy_array(alloca, &Arg, arrTy);
+		}
+		else if(!ct.is_addr_taken(name)){
+			// scalar in SSA form; argument is its initial value.
+			ct.insert_ssa(name, Arg.getType());
+			ct.write_var(name, BB, &Arg);
+		}
+		else{
+			// allocate space according to type.
+			llvm::AllocaInst* alloca =
+				Builder.CreateAlloca(Arg.getType(), nullptr, name);
+			// insert alloca in cgen table.
+			ct.insert(name, alloca);
+			// Store the initial value into the alloca.
+			Builder.CreateStore(&Arg, alloca);
+		}
 	}
 
 	body->cgen();
 	// exit block
 	Builder.CreateBr(ExitBB);
 	F->getBasicBlockList().push_back(ExitBB);
+	ct.seal(ExitBB);
 	ct.setCurrentBB(ExitBB);
 	Builder.SetInsertPoint(ExitBB);
 	/* return */
 	if(isFunction){
 		// load and return result.
-		llvm::Value* res = Builder.CreateLoad(result_alloca, "result");
+		llvm::Value* res;
+		if(result_alloca){
+			res = Builder.CreateLoad(result_alloca, "result");
+		}
+		else{
+			res = ct.read_var("result", ExitBB);
+		}
 		Builder.CreateRet(res);
 	}
 	else{
 		// void return for procedure.
 		Builder.CreateRetVoid();
 	}
+	ct.seal_remaining();
+	cgen_remove_bounds_checks(F);
+	cgen_stack_objects(F);
+	cgen_tail_calls(F, ExitBB);
 	ct.closeScope();
 	// return to parent building block.
 	Builder.SetInsertPoint(ct.getCurrentBB());
@@ -947,30 +1891,107 @@ void Return::cgen(){
 	llvm::Function* TheFunction=ct.getFunction();
 	llvm::BasicBlock *BB =
 		llvm::BasicBlock::Create(TheContext, "garb", TheFunction);
+	ct.seal(BB);
 	ct.setCurrentBB(BB);
 	Builder.SetInsertPoint(BB);
 }
 
 
 static void create_mem_funcs(){
-	/* create malloc and free declarations */
-	// create 'i8* malloc(i64)'
-	llvm::FunctionType* malloc_type = llvm::FunctionType::get(
+	/* create runtime allocator declarations */
+	llvm::FunctionType* alloc_type = llvm::FunctionType::get(
 		llvm::PointerType::get(i8, 0), std::vector<llvm::Type *>{i64}, false
 	);
-	llvm::Function::Create(
-		malloc_type, llvm::Function::ExternalLinkage, "malloc", TheModule.get()
+	/* arrays ('new [n] p'); large ones are mapped directly */
+	// create 'i8* pcl_alloc_array(i64)'
+	llvm::Function* alloc_arr_f = llvm::Function::Create(
+		alloc_type, llvm::Function::ExternalLinkage, "pcl_alloc_array",
+		TheModule.get()
 	);
-	// create 'void free(i8*)'
-	llvm::FunctionType* free_type = llvm::FunctionType::get(
+	// result is fresh memory, like malloc's.
+	alloc_arr_f->setReturnDoesNotAlias();
+	alloc_arr_f->addFnAttr(llvm::Attribute::NoUnwind);
+	// create 'void pcl_free_array(i8*)'
+	llvm::FunctionType* free_arr_type = llvm::FunctionType::get(
 		voidTy, llvm::PointerType::get(i8, 0), false
 	);
-	llvm::Function::Create(
-		free_type, llvm::Function::ExternalLinkage, "free", TheModule.get()
+	llvm::Function* free_arr_f = llvm::Function::Create(
+		free_arr_type, llvm::Function::ExternalLinkage, "pcl_free_array",
+		TheModule.get()
+	);
+	free_arr_f->addParamAttr(0, llvm::Attribute::NoCapture);
+	free_arr_f->addFnAttr(llvm::Attribute::NoUnwind);
+	/* single objects ('new p') use the runtime pool allocator */
+	// create 'i8* pcl_alloc(i64)'
+	llvm::Function* alloc_f = llvm::Function::Create(
+		alloc_type, llvm::Function::ExternalLinkage, "pcl_alloc", TheModule.get()
+	);
+	alloc_f->setReturnDoesNotAlias();
+	alloc_f->addFnAttr(llvm::Attribute::NoUnwind);
+	// create 'void pcl_free(i8*, i64)'
+	llvm::FunctionType* pool_free_type = llvm::FunctionType::get(
+		voidTy, std::vector<llvm::Type *>{llvm::PointerType::get(i8, 0), i64}, false
+	);
+	llvm::Function* free_f = llvm::Function::Create(
+		pool_free_type, llvm::Function::ExternalLinkage, "pcl_free", TheModule.get()
 	);
+	free_f->addParamAttr(0, llvm::Attribute::NoCapture);
+	free_f->addFnAttr(llvm::Attribute::NoUnwind);
+	if(gc_heap){
+		/* '--gc': all objects come from the collected heap */
+		// create 'i8* pcl_gc_alloc(i64)'
+		llvm::Function* gc_alloc_f = llvm::Function::Create(
+			alloc_type, llvm::Function::ExternalLinkage, "pcl_gc_alloc",
+			TheModule.get()
+		);
+		gc_alloc_f->setReturnDoesNotAlias();
+		gc_alloc_f->addFnAttr(llvm::Attribute::NoUnwind);
+	}
+}
+
+static std::unique_ptr<llvm::Module> load_runtime(){
+	/* parse runtime library bitcode; the module adopts its target. */
+	llvm::SMDiagnostic err;
+	std::unique_ptr<llvm::Module> lib =
+		llvm::parseIRFile(runtime_bc, err, TheContext);
+	if(!lib){
+		err.print("pcl", llvm::errs());
+		exit(1);
+	}
+	TheModule->setDataLayout(lib->getDataLayout());
+	TheModule->setTargetTriple(lib->getTargetTriple());
+	return lib;
+}
+
+static void link_runtime(std::unique_ptr<llvm::Module> lib){
+	/* link the used part of the runtime library into the module, so
+	     that it is optimized together with the program. */
+	if(llvm::Linker::linkModules(
+			*TheModule, std::move(lib), llvm::Linker::Flags::LinkOnlyNeeded)){
+		std::cerr << "Cgen:: Cannot link runtime library " << runtime_bc
+			<< std::endl;
+		exit(1);
+	}
+	// whole program is in the module; only main is visible outside,
+	//   so unused runtime routines can be removed.
+	for(auto &F : *TheModule){
+		if(!F.isDeclaration() and F.getName()!="main"){
+			F.setLinkage(llvm::GlobalValue::InternalLinkage);
+		}
+	}
+	for(auto &G : TheModule->globals()){
+		if(!G.isDeclaration() and !G.hasAppendingLinkage()){
+			G.setLinkage(llvm::GlobalValue::InternalLinkage);
+		}
+	}
 }
+
 void Program::cgen(){
 	TheModule = llvm::make_unique<llvm::Module>(filename, TheContext);
+	std::unique_ptr<llvm::Module> lib;
+	if(runtime_bc){
+		lib = load_runtime();
+	}
 	// 'i32 main()'
 	llvm::FunctionType* main_t = llvm::FunctionType::get(
 		i32, std::vector<llvm::Type *>{}, false
@@ -991,12 +2012,19 @@ void Program::cgen(){
 	ct.openScope(main_f);
 	// main scope.
 	llvm::BasicBlock *BB = llvm::BasicBlock::Create(TheContext, "entry", main_f);
+	ct.seal(BB);
 	ct.setCurrentBB(BB);
 	Builder.SetInsertPoint(BB);
 	body->cgen();
 	Builder.CreateRet(c32(0));
+	ct.seal_remaining();
+	cgen_remove_bounds_checks(main_f);
+	cgen_stack_objects(main_f);
 	ct.closeScope();
 	ct.closeScope();
+	if(lib){
+		link_runtime(std::move(lib));
+	}
 	TheModule->print(llvm::outs(), nullptr);
 }
 
@@ -1008,24 +2036,13 @@ std::vector<llvm::Value*> ExprList::cgen(std::vector<bool> by_ref){
 	for(uint i=0; i<list.size(); i++){
 		if(by_ref[i]){ // passing mode is by-reference
 			// return address
-			llvm::Value* tmp=static_cast<LValue*>(list[i])->getAddr();
-			if(!types[i]->get_name().compare("array")){
-				// if array by reference return first element address
-
-				if(static_cast<llvm::PointerType*>(tmp->getType())
-						->getElementType()->isArrayTy()){
-					// GEP needs first a 0 index because arr is pointer (alloca) to array
-					tmp = Builder.CreateGEP(
-						tmp, std::vector<llvm::Value*> {c32(0),c32(0)}, "cast");
-				}
-				else{
-					// array reference is pointer so needs only one index
-					tmp = Builder.CreateGEP(
-						tmp, std::vector<llvm::Value*> {c32(0)}, "cast"
-					);
-				}
-			}
-			ret[i]=tmp;
+			// (array is converted to the parameter type by the call).
+			ret[i]=static_cast<LValue*>(list[i])->getAddr();
+		}
+		else if(!types[i]->get_name().compare("array") and list[i]->isLValue()){
+			// by-value array; address of the array (copied by the callee
+			//   or the caller when needed).
+			ret[i]=static_cast<LValue*>(list[i])->getAddr();
 		}
 		else{
 			ret[i]=list[i]->cgen();
@@ -1035,6 +2052,137 @@ std::vector<llvm::Value*> ExprList::cgen(std::vector<bool> by_ref){
 }
 
 
+static llvm::Function* libm_function(std::string name){
+	// 'double name(double)' of the C math library.
+	llvm::FunctionType* FT = llvm::FunctionType::get(
+		doubleTy, std::vector<llvm::Type *>{doubleTy}, false);
+	llvm::Function* F = external_function(name, FT);
+	if(!F){
+		F = llvm::Function::Create(
+			FT, llvm::Function::ExternalLinkage, name, TheModule.get()
+		);
+		// no errno in pcl; result depends only on the argument.
+		F->addFnAttr(llvm::Attribute::ReadNone);
+		F->addFnAttr(llvm::Attribute::NoUnwind);
+	}
+	return F;
+}
+
+static llvm::Function* bits_function(const char* name, llvm::Type* retTy){
+	/* 'pcl_count_bits(i64* words, i32 n)' or
+	     'pcl_fill_bits(i64* words, i32 n, i8 b)' of the runtime. */
+	std::vector<llvm::Type*> params{llvm::PointerType::get(i64, 0), i32};
+	if(retTy==voidTy) params.push_back(i8);
+	llvm::FunctionType* FT = llvm::FunctionType::get(retTy, params, false);
+	llvm::Function* F = external_function(name, FT);
+	if(!F){
+		F = llvm::Function::Create(
+			FT, llvm::Function::ExternalLinkage, name, TheModule.get()
+		);
+		F->addFnAttr(llvm::Attribute::NoUnwind);
+		F->addFnAttr(llvm::Attribute::ArgMemOnly);
+		if(retTy!=voidTy) F->addFnAttr(llvm::Attribute::ReadOnly);
+	}
+	return F;
+}
+
+static llvm::Value* cgen_builtin(llvm::Function* callee,
+		std::vector<llvm::Value*> args){
+	/* math and conversion built-ins are emitted in place (as LLVM
+	     intrinsics or plain instructions) so that they can be folded,
+	     hoisted and vectorized; returns nullptr for all other callees. */
+	std::string name = callee->getName().str();
+	llvm::Intrinsic::ID id = llvm::Intrinsic::not_intrinsic;
+	if(name=="sqrt_pcl") id = llvm::Intrinsic::sqrt;
+	else if(name=="fabs_pcl") id = llvm::Intrinsic::fabs;
+	else if(name=="sin_pcl") id = llvm::Intrinsic::sin;
+	else if(name=="cos_pcl") id = llvm::Intrinsic::cos;
+	else if(name=="exp_pcl") id = llvm::Intrinsic::exp;
+	else if(name=="ln_pcl") id = llvm::Intrinsic::log;
+	if(id!=llvm::Intrinsic::not_intrinsic){
+		llvm::Function* F =
+			llvm::Intrinsic::getDeclaration(TheModule.get(), id, doubleTy);
+		return Builder.CreateCall(F, args, "calltmp");
+	}
+	if(name=="tan_pcl"){
+		return Builder.CreateCall(libm_function("tan"), args, "calltmp");
+	}
+	if(name=="arctan_pcl"){
+		return Builder.CreateCall(libm_function("atan"), args, "calltmp");
+	}
+	if(name=="pi_pcl"){
+		return cf(3.14159265358979323846);
+	}
+	if(name=="abs_pcl"){
+		llvm::Value* neg = Builder.CreateNeg(args[0], "negtmp");
+		llvm::Value* is_neg = Builder.CreateICmpSLT(args[0], c32(0), "cmptmp");
+		return Builder.CreateSelect(is_neg, neg, args[0], "abstmp");
+	}
+	if(name=="trunc_pcl"){
+		// fptosi rounds toward zero.
+		return Builder.CreateFPToSI(args[0], i32, "trunctmp");
+	}
+	if(name=="round_pcl"){
+		// halfway cases away from zero, like C round().
+		llvm::Function* F = llvm::Intrinsic::getDeclaration(
+			TheModule.get(), llvm::Intrinsic::round, doubleTy
+		);
+		llvm::Value* r = Builder.CreateCall(F, args, "roundtmp");
+		return Builder.CreateFPToSI(r, i32, "roundtmp");
+	}
+	if(name=="ord_pcl"){
+		return Builder.CreateZExt(args[0], i32, "ordtmp");
+	}
+	if(name=="chr_pcl"){
+		return Builder.CreateTrunc(args[0], i8, "chrtmp");
+	}
+	if(name=="length_pcl"){
+		return Builder.CreateExtractValue(
+			args[0], std::vector<unsigned>{1, 0}, "length");
+	}
+	if(name=="countTrue_pcl" or name=="fillBoolean_pcl"){
+		// whole words of a packed array at a time.
+		std::vector<llvm::Value*> bits_args{
+			Builder.CreateExtractValue(args[0], 0, "data"),
+			Builder.CreateExtractValue(args[0], std::vector<unsigned>{1, 0}, "length")
+		};
+		if(name=="countTrue_pcl"){
+			return Builder.CreateCall(bits_function("pcl_count_bits", i32),
+				bits_args, "calltmp");
+		}
+		bits_args.push_back(args[1]);
+		return Builder.CreateCall(bits_function("pcl_fill_bits", voidTy),
+			bits_args);
+	}
+	return nullptr;
+}
+
+bool Call::unchanged_during_call(Expr* arg, llvm::Value* addr){
+	/* storage of a by-value array argument can't be written while the
+	     callee runs, so the callee may read it in place. */
+	llvm::Value* base = addr->stripPointerCasts();
+	if(llvm::GlobalVariable* G = llvm::dyn_cast<llvm::GlobalVariable>(base)){
+		// string literal.
+		if(G->isConstant()) return true;
+	}
+	Id* root = arg->isLValue() ? static_cast<LValue*>(arg)->get_root() : nullptr;
+	if(root and !ct.is_ssa(root->get_name())){
+		llvm::Value* var = ct.lookup(root->get_name());
+		if(llvm::isa<llvm::AllocaInst>(var) and
+				!ct.is_addr_taken(root->get_name())){
+			// local that only this subprogram can name.
+			return true;
+		}
+		if(llvm::Argument* A = llvm::dyn_cast<llvm::Argument>(var)){
+			// array argument read in place; unchanged for the whole call
+			//   of this subprogram.
+			if(A->hasNoAliasAttr() and A->onlyReadsMemory()) return true;
+		}
+	}
+	// anything else is unchanged only if the callee writes no memory.
+	return callee_type->get_effect()!=CallableType::WritesMemory;
+}
+
 llvm::Value* Call::cgen_common(){
 	llvm::Function* callee = ct.function_lookup(name);
 	if(!callee){
@@ -1049,7 +2197,60 @@ llvm::Value* Call::cgen_common(){
 		outer_vars->cgen(std::vector<bool>(outer_vars->size(),true));
 	// merge all arguments
 	args.insert(args.end(), outer.begin(), outer.end());
-	return Builder.CreateCall(callee, args);
+	llvm::FunctionType* FT = callee->getFunctionType();
+	std::vector<TSPtr> formal_types = callee_type->get_types();
+	for(uint i=0; i<exprs->size(); i++){
+		// fixed array passed as 'array of' takes its static size along.
+		if(!by_ref[i] or !formal_types[i]->is_incomplete() or
+				args[i]->getType()->isStructTy()){
+			continue;
+		}
+		TSPtr t = (*exprs)[i]->get_type();
+		llvm::Type* descTy = FT->getParamType(i)->isStructTy() ?
+			FT->getParamType(i) :
+			std::static_pointer_cast<ArrType>(t)->cgen_descriptor();
+		args[i] = cgen_descriptor_of(args[i], t, descTy);
+	}
+	if(llvm::Value* v = cgen_builtin(callee, args)) return v;
+	for(uint i=0; i<args.size(); i++){
+		llvm::Type* paramTy = FT->getParamType(i);
+		if(paramTy->isStructTy()){
+			// dynamic array (or pointer to one) takes its length along.
+			TSPtr t = i<exprs->size() ? (*exprs)[i]->get_type() :
+				(*outer_vars)[i-exprs->size()]->get_type();
+			args[i] = cgen_descriptor_of(args[i], t, paramTy);
+			continue;
+		}
+		if(!callee_type->by_pointer(i)){
+			llvm::Value* a = data_pointer(args[i]);
+			if(a->getType()->isPointerTy()){
+				// array by reference is passed as pointer to its first
+				//   element; nil takes the parameter type.
+				args[i] = Builder.CreateBitCast(a, paramTy);
+			}
+			continue;
+		}
+		llvm::Type* arrTy = paramTy->getPointerElementType();
+		if(!args[i]->getType()->isPointerTy()){
+			// array value (not in memory); store it to a temporary.
+			llvm::AllocaInst* tmp = cgen_entry_alloca(arrTy, "argtmp");
+			Builder.CreateStore(args[i], tmp);
+			args[i] = tmp;
+			continue;
+		}
+		if(callee_type->shares_array(i) and
+				!unchanged_during_call((*exprs)[i], args[i])){
+			// callee reads the array in place; give it a private copy.
+			llvm::AllocaInst* tmp = cgen_entry_alloca(arrTy, "argtmp");
+			cgen_copy_array(tmp, args[i], arrTy);
+			args[i] = tmp;
+		}
+		args[i] = Builder.CreateBitCast(args[i], paramTy);
+	}
+	llvm::CallInst* call = Builder.CreateCall(callee, args);
+	// calling convention of call must match callee.
+	call->setCallingConv(callee->getCallingConv());
+	return call;
 }
 
 void ProcCall::cgen(){
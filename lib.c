@@ -3,47 +3,573 @@
 #include "math.h"
 #include "string.h"
 #include "stdlib.h"
+#include "unistd.h"
+#include "errno.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "fcntl.h"
+#include "time.h"
+#include "lib_tables.h"
+
+/* Output is collected in a buffer of our own and written to stdout with
+ * write(2): it is flushed when full, before waiting for input and at exit.
+ */
+#define OUT_SIZE (1<<16)
+
+static char out_buf[OUT_SIZE];
+static size_t out_len=0;
+
+static void out_write(const char *p, size_t n){
+	while(n>0){
+		ssize_t w=write(STDOUT_FILENO, p, n);
+		if(w<0){
+			if(errno==EINTR) continue;
+			exit(1);
+		}
+		p+=w;
+		n-=w;
+	}
+}
+
+static void out_flush(){
+	out_write(out_buf, out_len);
+	out_len=0;
+}
+
+__attribute__((constructor))
+static void out_init(){
+	atexit(out_flush);
+}
+
+static void out_bytes(const char *p, size_t n){
+	if(out_len+n>OUT_SIZE){
+		out_flush();
+		if(n>OUT_SIZE){
+			// too big to be buffered; write it as is.
+			out_write(p, n);
+			return;
+		}
+	}
+	memcpy(out_buf+out_len, p, n);
+	out_len+=n;
+}
+
+// "00" "01" ... "99": two decimal digits per lookup.
+static const char digit_pairs[201]=
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static inline void out_integer(int32_t i){
+	// sign and at most 10 digits.
+	char tmp[11];
+	char *p=tmp+sizeof(tmp);
+	uint32_t u= i<0 ? -(uint32_t)i : (uint32_t)i;
+	if(out_len+sizeof(tmp)>OUT_SIZE) out_flush();
+	while(u>=100){
+		const char *d=digit_pairs+2*(u%100);
+		u/=100;
+		*--p=d[1];
+		*--p=d[0];
+	}
+	if(u>=10){
+		const char *d=digit_pairs+2*u;
+		*--p=d[1];
+		*--p=d[0];
+	}
+	else{
+		*--p='0'+u;
+	}
+	if(i<0) *--p='-';
+	memcpy(out_buf+out_len, p, tmp+sizeof(tmp)-p);
+	out_len+=tmp+sizeof(tmp)-p;
+}
 
 void writeInteger_pcl(int32_t i){
-	printf("%d",i);
+	out_integer(i);
 }
 
 void writeBoolean_pcl(uint8_t b){
-	printf("%s", b ? "true" : "false");
+	if(b) out_bytes("true", 4);
+	else out_bytes("false", 5);
 }
 
 void writeChar_pcl(uint8_t c){
-	printf("%c",c);
+	if(out_len==OUT_SIZE) out_flush();
+	out_buf[out_len++]=c;
+}
+
+/* Shortest decimal digits of a double with Grisu2 (F. Loitsch, "Printing
+ * Floating-Point Numbers Quickly and Accurately with Integers"). The digits
+ * always read back to the same double and are the shortest in almost all
+ * cases.
+ */
+typedef struct { uint64_t f; int e; } diyfp;
+
+static diyfp diyfp_mul(diyfp x, diyfp y){
+	// upper 64 bits of the product, rounded.
+	unsigned __int128 p=(unsigned __int128)x.f*y.f;
+	diyfp r={(uint64_t)(p>>64)+((uint64_t)(p>>63)&1), x.e+y.e+64};
+	return r;
+}
+
+static diyfp diyfp_normalize(diyfp x){
+	int lz=__builtin_clzll(x.f);
+	x.f<<=lz;
+	x.e-=lz;
+	return x;
+}
+
+static void grisu2_round(char *buf, int len, uint64_t dist, uint64_t delta,
+		uint64_t rest, uint64_t ten_k){
+	// move last digit towards the exact value while staying in range.
+	while(rest<dist && delta-rest>=ten_k
+			&& (rest+ten_k<dist || dist-rest>rest+ten_k-dist)){
+		buf[len-1]--;
+		rest+=ten_k;
+	}
+}
+
+static int grisu2(char *buf, int *dec_exp, double r){
+	uint64_t bits;
+	memcpy(&bits, &r, sizeof(bits));
+	uint64_t F=bits&((1ULL<<52)-1);
+	int E=(int)(bits>>52)&0x7FF;
+	diyfp v= E ? (diyfp){F|(1ULL<<52), E-1075} : (diyfp){F, -1074};
+	// boundaries m-, m+ of the interval rounding to r.
+	diyfp m_plus=diyfp_normalize((diyfp){2*v.f+1, v.e-1});
+	diyfp m_minus= (F==0 && E>1) ?
+		(diyfp){4*v.f-1, v.e-2} : (diyfp){2*v.f-1, v.e-1};
+	m_minus.f<<=m_minus.e-m_plus.e;
+	m_minus.e=m_plus.e;
+	v=diyfp_normalize(v);
+
+	// scale by a cached 10^-k so that the exponent lands in [-60,-32].
+	int f=-61-m_plus.e;
+	int k=(f*78913)/(1<<18)+(f>0);
+	int index=(-POW10_MIN_K+k+(POW10_STEP_K-1))/POW10_STEP_K;
+	diyfp c={cached_pow10[index].f, cached_pow10[index].e};
+	diyfp w=diyfp_mul(v, c);
+	diyfp w_minus=diyfp_mul(m_minus, c);
+	diyfp w_plus=diyfp_mul(m_plus, c);
+	// shrink the interval by one unit to stay safe.
+	uint64_t lo=w_minus.f+1;
+	uint64_t hi=w_plus.f-1;
+	*dec_exp=-cached_pow10[index].k;
+
+	// generate digits of hi until they are within hi-lo.
+	uint64_t delta=hi-lo;
+	uint64_t dist=hi-w.f;
+	int shift=-w_plus.e;
+	uint64_t one=1ULL<<shift;
+	uint32_t p1=(uint32_t)(hi>>shift);
+	uint64_t p2=hi&(one-1);
+	uint32_t pow10=1000000000;
+	int n=10;
+	int len=0;
+	while(pow10>p1 && n>1){
+		pow10/=10;
+		n--;
+	}
+	while(n>0){
+		buf[len++]='0'+p1/pow10;
+		p1%=pow10;
+		n--;
+		uint64_t rest=((uint64_t)p1<<shift)+p2;
+		if(rest<=delta){
+			*dec_exp+=n;
+			grisu2_round(buf, len, dist, delta, rest, (uint64_t)pow10<<shift);
+			return len;
+		}
+		pow10/=10;
+	}
+	for(;;){
+		p2*=10;
+		buf[len++]='0'+(p2>>shift);
+		p2&=one-1;
+		delta*=10;
+		dist*=10;
+		(*dec_exp)--;
+		if(p2<=delta) break;
+	}
+	grisu2_round(buf, len, dist, delta, p2, one);
+	return len;
+}
+
+static int format_exponent(char *p, int e){
+	// at least two exponent digits, like printf's %e.
+	char *s=p;
+	*p++= e<0 ? '-' : '+';
+	if(e<0) e=-e;
+	if(e>=100){
+		*p++='0'+e/100;
+		e%=100;
+	}
+	*p++='0'+e/10;
+	*p++='0'+e%10;
+	return p-s;
+}
+
+static void out_real(double r){
+	// sign, 17 digits, point, zeros and exponent.
+	char tmp[32];
+	char digits[18];
+	char *p=tmp;
+	if(r!=r){
+		out_bytes("nan", 3);
+		return;
+	}
+	if(signbit(r)){
+		*p++='-';
+		r=-r;
+	}
+	if(r==0){
+		memcpy(p, "0.0", 3);
+		out_bytes(tmp, p-tmp+3);
+		return;
+	}
+	if(isinf(r)){
+		memcpy(p, "inf", 3);
+		out_bytes(tmp, p-tmp+3);
+		return;
+	}
+	int k;
+	int n=grisu2(digits, &k, r);
+	// value is 0.digits * 10^point.
+	int point=n+k;
+	if(n<=point && point<=17){
+		// integral: digits, zeros, ".0"
+		memcpy(p, digits, n);
+		p+=n;
+		memset(p, '0', point-n);
+		p+=point-n;
+		*p++='.';
+		*p++='0';
+	}
+	else if(0<point && point<=17){
+		// point among the digits.
+		memcpy(p, digits, point);
+		p+=point;
+		*p++='.';
+		memcpy(p, digits+point, n-point);
+		p+=n-point;
+	}
+	else if(-5<point && point<=0){
+		// "0.", leading zeros, digits.
+		*p++='0';
+		*p++='.';
+		memset(p, '0', -point);
+		p+=-point;
+		memcpy(p, digits, n);
+		p+=n;
+	}
+	else{
+		// d[.ddd]e+XX
+		*p++=digits[0];
+		if(n>1){
+			*p++='.';
+			memcpy(p, digits+1, n-1);
+			p+=n-1;
+		}
+		*p++='e';
+		p+=format_exponent(p, point-1);
+	}
+	out_bytes(tmp, p-tmp);
 }
 
 void writeReal_pcl(double r){
-	printf("%lf",r);
+	out_real(r);
 }
 
 void writeString_pcl(uint8_t s[]){
-	printf("%s",s );
+	out_bytes((const char*)s, strlen((const char*)s));
 }
 
-int32_t readInteger_pcl(){
-	char buf[256];
-	if(fgets(buf,sizeof(buf),stdin)){
-		return atoi(buf);
+/* Bulk output: n elements of a, separated by spaces. */
+void writeIntegerArray_pcl(int32_t n, int32_t a[]){
+	for(int32_t i=0; i<n; i++){
+		if(i) writeChar_pcl(' ');
+		out_integer(a[i]);
+	}
+}
+
+void writeRealArray_pcl(int32_t n, double a[]){
+	for(int32_t i=0; i<n; i++){
+		if(i) writeChar_pcl(' ');
+		out_real(a[i]);
+	}
+}
+
+void writeCharArray_pcl(int32_t n, uint8_t a[]){
+	// characters are written as they are.
+	if(n>0) out_bytes((const char*)a, n);
+}
+
+/* Decimal text to double: exact fast path (Clinger) when the digits and
+ * the power of ten are both exact doubles, otherwise the Eisel-Lemire
+ * algorithm ("Number Parsing at a Gigabyte per Second"). Inputs with more
+ * than 19 significant digits and special values go to strtod.
+ */
+static const double exact_pow10[]={
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static double eisel_lemire(uint64_t w, int64_t q){
+	/* w * 10^q, w != 0 */
+	uint64_t bits;
+	double r;
+	if(q<POW5_MIN_Q){
+		bits=0;
+	}
+	else if(q>POW5_MAX_Q){
+		bits=0x7FFULL<<52;
+	}
+	else{
+		int lz=__builtin_clzll(w);
+		w<<=lz;
+		const uint64_t *pow5=pow5_128+2*(q-POW5_MIN_Q);
+		unsigned __int128 prod=(unsigned __int128)w*pow5[0];
+		uint64_t high=(uint64_t)(prod>>64);
+		uint64_t low=(uint64_t)prod;
+		if((high&0x1FF)==0x1FF){
+			// truncated power may matter; use the lower 64 bits too.
+			uint64_t high2=(uint64_t)(((unsigned __int128)w*pow5[1])>>64);
+			low+=high2;
+			if(high2>low) high++;
+		}
+		int upperbit=(int)(high>>63);
+		uint64_t mantissa=high>>(upperbit+9);
+		// floor(log2(10^q)) + 63 + upperbit - lz, biased.
+		int power2=(int)(((217706*q)>>16)+63+upperbit-lz+1023);
+		if(power2<=0){
+			// subnormal or zero.
+			if(-power2+1>=64) return 0;
+			mantissa>>=-power2+1;
+			mantissa+=mantissa&1;
+			mantissa>>=1;
+			power2= mantissa<(1ULL<<52) ? 0 : 1;
+			bits=((uint64_t)power2<<52)|(mantissa&((1ULL<<52)-1));
+			memcpy(&r, &bits, sizeof(bits));
+			return r;
+		}
+		if(low<=1 && q>=-4 && q<=23 && (mantissa&3)==1
+				&& (mantissa<<(upperbit+9))==high){
+			// exactly halfway: round to even.
+			mantissa&=~1ULL;
+		}
+		mantissa+=mantissa&1;
+		mantissa>>=1;
+		if(mantissa>=(2ULL<<52)){
+			mantissa=1ULL<<52;
+			power2++;
+		}
+		if(power2>=0x7FF){
+			bits=0x7FFULL<<52;
+		}
+		else{
+			bits=((uint64_t)power2<<52)|(mantissa&((1ULL<<52)-1));
+		}
+	}
+	memcpy(&r, &bits, sizeof(bits));
+	return r;
+}
+
+static double parse_real(const char *s, const char **end){
+	const char *start=s;
+	while(*s==' ' || *s=='\t' || *s=='\n' || *s=='\r') s++;
+	int neg=0;
+	if(*s=='-' || *s=='+'){
+		neg= *s=='-';
+		s++;
+	}
+	uint64_t w=0;
+	int64_t q=0;
+	int digits=0;
+	int many=0;
+	const char *first=s;
+	while(*s=='0') s++;
+	for(; *s>='0' && *s<='9'; s++){
+		if(digits<19) w=10*w+(*s-'0');
+		else q++;
+		many|= digits>=19 && *s!='0';
+		digits++;
+	}
+	if(*s=='.'){
+		s++;
+		if(!digits){
+			while(*s=='0'){
+				s++;
+				q--;
+			}
+		}
+		for(; *s>='0' && *s<='9'; s++){
+			if(digits<19){
+				w=10*w+(*s-'0');
+				q--;
+			}
+			many|= digits>=19 && *s!='0';
+			digits++;
+		}
+	}
+	if(s==first || (s==first+1 && *first=='.')){
+		// no digits; leave special values (inf, nan) to strtod.
+		return strtod(start, (char**)end);
+	}
+	if(*s=='e' || *s=='E'){
+		const char *e=s+1;
+		int eneg=0;
+		if(*e=='-' || *e=='+'){
+			eneg= *e=='-';
+			e++;
+		}
+		if(*e>='0' && *e<='9'){
+			int64_t x=0;
+			for(; *e>='0' && *e<='9'; e++){
+				if(x<100000) x=10*x+(*e-'0');
+			}
+			q+= eneg ? -x : x;
+			s=e;
+		}
+	}
+	if(end) *end=s;
+	if(many){
+		// more than 19 significant digits.
+		return strtod(start, NULL);
+	}
+	double r;
+	if(w==0){
+		r=0;
+	}
+	else if(w<=(1ULL<<53) && q>=-22 && q<=22){
+		r= q<0 ? (double)w/exact_pow10[-q] : (double)w*exact_pow10[q];
 	}
 	else{
-		fprintf(stderr,"Too long input\n");
+		r=eisel_lemire(w, q);
+	}
+	return neg ? -r : r;
+}
+
+/* Input is read through a buffer of our own (or the whole file, mapped,
+ * when stdin is a regular file). Values may be separated by any
+ * whitespace; after a value the rest of its line is consumed if it is
+ * blank, so a following readString starts on the next line as before.
+ */
+#define IN_SIZE (1<<16)
+
+static char in_store[IN_SIZE];
+static const char *in_buf=in_store;
+static size_t in_pos=0;
+static size_t in_end=0;
+static int in_mapped=0;
+
+__attribute__((constructor))
+static void in_init(){
+	struct stat st;
+	if(fstat(STDIN_FILENO, &st) || !S_ISREG(st.st_mode) || st.st_size<=0){
+		return;
+	}
+	void *p=mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+	if(p==MAP_FAILED) return;
+	madvise(p, st.st_size, MADV_SEQUENTIAL);
+	in_buf=p;
+	in_end=st.st_size;
+	in_mapped=1;
+}
+
+static int in_fill(){
+	/* refill the (fully consumed) buffer; returns 0 at end of input. */
+	if(in_mapped) return 0;
+	// output must be visible before waiting for input.
+	out_flush();
+	for(;;){
+		ssize_t n=read(STDIN_FILENO, in_store, IN_SIZE);
+		if(n<0 && errno==EINTR) continue;
+		if(n<=0) return 0;
+		in_pos=0;
+		in_end=n;
+		return 1;
+	}
+}
+
+static inline int in_peek(){
+	if(in_pos==in_end && !in_fill()) return EOF;
+	return (unsigned char)in_buf[in_pos];
+}
+
+static inline int is_space(int c){
+	return c==' ' || c=='\n' || c=='\t' || c=='\r' || c=='\v' || c=='\f';
+}
+
+static void in_skip_space(){
+	int c;
+	while((c=in_peek())!=EOF && is_space(c)) in_pos++;
+	if(c==EOF){
+		fprintf(stderr,"Unexpected end of input\n");
 		exit(1);
 	}
+}
+
+static void in_end_token(){
+	/* skip rest of a value and, if blank, of its line. */
+	int c;
+	while((c=in_peek())!=EOF && !is_space(c)) in_pos++;
+	while(c==' ' || c=='\t' || c=='\r'){
+		in_pos++;
+		c=in_peek();
+	}
+	if(c=='\n') in_pos++;
+}
+
+static size_t in_token(char *buf, size_t size){
+	/* copy at most size-1 chars of next value into buf. */
+	size_t n=0;
+	int c;
+	in_skip_space();
+	while(n<size-1 && (c=in_peek())!=EOF && !is_space(c)){
+		buf[n++]=c;
+		in_pos++;
+	}
+	buf[n]='\0';
+	in_end_token();
+	return n;
+}
+
+static int32_t in_integer(){
+	in_skip_space();
+	int c=in_peek();
+	int neg= c=='-';
+	if(c=='-' || c=='+') in_pos++;
+	uint32_t u=0;
+	while((c=in_peek())>='0' && c<='9'){
+		u=10*u+(c-'0');
+		in_pos++;
+	}
+	in_end_token();
+	return neg ? -u : u;
+}
 
+static double in_real(){
+	char buf[512];
+	in_token(buf, sizeof(buf));
+	return parse_real(buf, NULL);
+}
+
+int32_t readInteger_pcl(){
+	return in_integer();
 }
 
 uint8_t readBoolean_pcl(){
 	char word[7];
 	uint8_t b;
-	if(!fgets(word, 7, stdin)){
-		fprintf(stderr,"Too long input\n");
-		exit(1);
-	}
-	word[strlen(word)-1]='\0';
+	in_token(word, sizeof(word));
 	if(!strcmp(word,"true")){
 		b=1;
 	}
@@ -59,36 +585,60 @@ uint8_t readBoolean_pcl(){
 	return b;
 }
 
-
-
 uint8_t readChar_pcl(){
-	return getc(stdin);
+	int c=in_peek();
+	if(c!=EOF) in_pos++;
+	return c;
 }
 
-
-
-
 double readReal_pcl(){
-	char buf[256];
-	if(!fgets(buf,sizeof(buf),stdin)){
-		fprintf(stderr,"Too long input\n");
-		exit(1);
+	return in_real();
+}
+
+void readString_pcl(int32_t size, uint8_t s[]){
+	/* rest of the line, without the newline, up to size-1 chars. */
+	int32_t n=0;
+	while(n<size-1 && (in_pos<in_end || in_fill())){
+		size_t len=in_end-in_pos;
+		if(len>(size_t)(size-1-n)) len=size-1-n;
+		const char *nl=memchr(in_buf+in_pos, '\n', len);
+		if(nl) len=nl-(in_buf+in_pos);
+		memcpy(s+n, in_buf+in_pos, len);
+		n+=len;
+		in_pos+=len;
+		if(nl){
+			in_pos++;
+			break;
+		}
 	}
-	return atof(buf);
+	s[n]='\0';
 }
 
 
+/* Bulk input: n values into a, as by the single-value reads. */
+void readIntegerArray_pcl(int32_t n, int32_t a[]){
+	for(int32_t i=0; i<n; i++){
+		a[i]=in_integer();
+	}
+}
 
-void readString_pcl(int32_t size, uint8_t s[]){
-	int i=0;
-	char c=getc(stdin);
-	while(c!='\n' && c!= EOF && i<size-1){
-		*s++=(uint8_t)c;
-		c=getc(stdin);
+void readRealArray_pcl(int32_t n, double a[]){
+	for(int32_t i=0; i<n; i++){
+		a[i]=in_real();
 	}
-	*s++='\0';
 }
 
+void readCharArray_pcl(int32_t n, uint8_t a[]){
+	/* next n characters as they are (fewer at end of input). */
+	int32_t i=0;
+	while(i<n && (in_pos<in_end || in_fill())){
+		size_t len=in_end-in_pos;
+		if(len>(size_t)(n-i)) len=n-i;
+		memcpy(a+i, in_buf+in_pos, len);
+		i+=len;
+		in_pos+=len;
+	}
+}
 
 
 int32_t abs_pcl(int32_t i){
@@ -147,3 +697,509 @@ int32_t ord_pcl(uint8_t c){
 uint8_t chr_pcl(int32_t i){
 	return (uint8_t) i;
 }
+
+
+/* Files mapped into memory; PCL sees them as dynamic arrays of char.
+ * Each mapping is remembered so that unmapFile knows its length.
+ */
+
+/* '^array of t' value: first element and number of elements. */
+struct pcl_array {
+	uint8_t *data;
+	int32_t length;
+};
+
+struct mapping {
+	void *addr;
+	size_t len;
+	struct mapping *next;
+};
+
+static struct mapping *mappings=NULL;
+
+static int32_t map_fd(int fd, size_t len, int prot, int flags,
+		struct pcl_array *p){
+	p->data=NULL;
+	p->length=0;
+	if(len>INT32_MAX){
+		// not indexable by a PCL integer.
+		close(fd);
+		return -1;
+	}
+	if(len==0){
+		close(fd);
+		return 0;
+	}
+	void *addr=mmap(NULL, len, prot, flags, fd, 0);
+	close(fd);
+	if(addr==MAP_FAILED) return -1;
+	struct mapping *m=malloc(sizeof(*m));
+	if(!m){
+		// without its record the mapping could not be unmapped.
+		munmap(addr, len);
+		return -1;
+	}
+	m->addr=addr;
+	m->len=len;
+	m->next=mappings;
+	mappings=m;
+	p->data=addr;
+	p->length=len;
+	return len;
+}
+
+int32_t mapFile_pcl(uint8_t name[], struct pcl_array *p){
+	struct stat st;
+	int fd=open((const char*)name, O_RDONLY);
+	if(fd<0) return -1;
+	if(fstat(fd, &st)){
+		close(fd);
+		return -1;
+	}
+	int32_t len=map_fd(fd, st.st_size, PROT_READ, MAP_PRIVATE, p);
+	if(len>0) madvise(p->data, len, MADV_SEQUENTIAL);
+	return len;
+}
+
+int32_t mapNewFile_pcl(uint8_t name[], int32_t size, struct pcl_array *p){
+	p->data=NULL;
+	p->length=0;
+	if(size<0) return -1;
+	int fd=open((const char*)name, O_RDWR|O_CREAT|O_TRUNC, 0666);
+	if(fd<0) return -1;
+	if(ftruncate(fd, size)){
+		close(fd);
+		return -1;
+	}
+	return map_fd(fd, size, PROT_READ|PROT_WRITE, MAP_SHARED, p);
+}
+
+void unmapFile_pcl(struct pcl_array *p){
+	if(!p->data) return;
+	for(struct mapping **m=&mappings; *m; m=&(*m)->next){
+		if((*m)->addr==p->data){
+			// shared (output) mappings are written back by the kernel.
+			struct mapping *dead=*m;
+			munmap(dead->addr, dead->len);
+			*m=dead->next;
+			free(dead);
+			p->data=NULL;
+			p->length=0;
+			return;
+		}
+	}
+	fprintf(stderr,"unmapFile: pointer is not a mapped file\n");
+	exit(1);
+}
+
+
+/* packed array of boolean: element i is bit i%64 of word i/64. Bits
+ * past the last element are unspecified, so counting masks them off.
+ */
+int32_t pcl_count_bits(uint64_t *words, int32_t n){
+	int32_t count=0;
+	int32_t full=n/64;
+	for(int32_t w=0; w<full; w++){
+		count+=__builtin_popcountll(words[w]);
+	}
+	if(n%64){
+		count+=__builtin_popcountll(words[full]&((1ULL<<(n%64))-1));
+	}
+	return count;
+}
+
+void pcl_fill_bits(uint64_t *words, int32_t n, uint8_t b){
+	memset(words, b ? 0xff : 0, ((size_t)n+63)/64*sizeof(uint64_t));
+}
+
+
+/* Allocator for 'new'/'dispose' of single objects. The compiler passes
+ * the object size to both, so blocks need no header: small sizes are
+ * rounded to a multiple of 8 and served from per-thread free lists,
+ * refilled from large chunks; freed blocks are reused but chunks are
+ * never returned. Larger objects go to malloc/free.
+ */
+#define POOL_GRAIN 8
+#define POOL_MAX 256
+#define POOL_CHUNK (1<<16)
+
+static __thread void *pool_free_list[POOL_MAX/POOL_GRAIN];
+static __thread char *pool_next=NULL;
+static __thread size_t pool_left=0;
+
+void *pcl_alloc(int64_t size){
+	if(size>POOL_MAX) return malloc(size);
+	size_t c=(size+POOL_GRAIN-1)/POOL_GRAIN;
+	if(c==0) c=1;
+	void *p=pool_free_list[c-1];
+	if(p){
+		pool_free_list[c-1]=*(void**)p;
+		return p;
+	}
+	size_t bytes=c*POOL_GRAIN;
+	if(pool_left<bytes){
+		// rest of the old chunk is left unused.
+		pool_next=malloc(POOL_CHUNK);
+		if(!pool_next){
+			fprintf(stderr,"Out of memory\n");
+			exit(1);
+		}
+		pool_left=POOL_CHUNK;
+	}
+	p=pool_next;
+	pool_next+=bytes;
+	pool_left-=bytes;
+	return p;
+}
+
+void pcl_free(void *p, int64_t size){
+	if(!p) return;
+	if(size>POOL_MAX){
+		free(p);
+		return;
+	}
+	size_t c=(size+POOL_GRAIN-1)/POOL_GRAIN;
+	if(c==0) c=1;
+	*(void**)p=pool_free_list[c-1];
+	pool_free_list[c-1]=p;
+}
+
+
+/* Allocator for 'new [n]'/'dispose []' of arrays. Every array is 64-byte
+ * aligned, with a header just before it recording how it was obtained.
+ * Large arrays are mapped directly: they start on a fresh page, are
+ * eligible for transparent huge pages, are zeroed lazily by the kernel and
+ * go back to the system with munmap.
+ */
+#define ARRAY_ALIGN 64
+#define ARRAY_MAP_MIN (1<<20)
+
+struct array_header {
+	void *base;
+	size_t len;
+};
+
+void *pcl_alloc_array(int64_t size){
+	struct array_header *h;
+	char *p;
+	if(size<0) size=0;
+	if(size<ARRAY_MAP_MIN){
+		size_t len=(size+2*ARRAY_ALIGN-1)/ARRAY_ALIGN*ARRAY_ALIGN;
+		char *base=aligned_alloc(ARRAY_ALIGN, len);
+		if(!base){
+			fprintf(stderr,"Out of memory\n");
+			exit(1);
+		}
+		p=base+ARRAY_ALIGN;
+		h=(struct array_header*)p-1;
+		h->base=base;
+		h->len=0;
+		return p;
+	}
+	size_t page=sysconf(_SC_PAGESIZE);
+	// header goes at the end of a page of its own.
+	size_t len=(size+2*page-1)/page*page;
+	char *base=mmap(NULL, len, PROT_READ|PROT_WRITE,
+		MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if(base==MAP_FAILED){
+		fprintf(stderr,"Out of memory\n");
+		exit(1);
+	}
+#ifdef MADV_HUGEPAGE
+	madvise(base+page, len-page, MADV_HUGEPAGE);
+#endif
+	p=base+page;
+	h=(struct array_header*)p-1;
+	h->base=base;
+	h->len=len;
+	return p;
+}
+
+void pcl_free_array(void *p){
+	if(!p) return;
+	struct array_header *h=(struct array_header*)p-1;
+	if(h->len) munmap(h->base, h->len);
+	else free(h->base);
+}
+
+
+/* Garbage-collected heap for 'new' in --gc mode ('dispose' only clears
+ * the pointer). Mark-sweep, conservative: every word of the stack, of
+ * the registers, of the program's data and of reachable objects that
+ * looks like a pointer into an allocated object keeps it alive.
+ *
+ * The heap is one reserved region of 64KiB pages. A page holds objects
+ * of one size class (multiples of 16 bytes up to 2KiB), handed out by a
+ * bump pointer on fresh pages and from a free list after a sweep; larger
+ * objects take runs of whole pages. Page descriptors live outside the
+ * scanned data. Setting PCL_GC_STATS in the environment prints the
+ * number of collections and pause times at exit.
+ */
+#define GC_PAGE_BITS 16
+#define GC_PAGE ((size_t)1<<GC_PAGE_BITS)
+#define GC_RESERVE ((size_t)1<<36)
+#define GC_GRAIN 16
+#define GC_SMALL_MAX 2048
+#define GC_CLASSES (GC_SMALL_MAX/GC_GRAIN)
+#define GC_SLOTS (GC_PAGE/GC_GRAIN)
+#define GC_MIN_TRIGGER ((size_t)8<<20)
+
+struct gc_page {
+	size_t obj_size;    // 0 for a free page
+	uint32_t run;       // large object: pages in its run (first page)
+	uint32_t first;     // large object: index of the run's first page
+	uint32_t live;
+	uint64_t alloc[GC_SLOTS/64];
+	uint64_t mark[GC_SLOTS/64];
+};
+
+struct gc_class {
+	char *bump;
+	char *bump_end;
+	void *free;
+};
+
+extern void *__libc_stack_end;
+extern char __data_start[];
+extern char _end[];
+
+static char *gc_base=NULL;
+static size_t gc_top=0;           // pages in use or freed so far
+static size_t gc_free_hint=0;     // no free page below this one
+static struct gc_page *gc_pages=NULL;
+static struct gc_class gc_classes[GC_CLASSES];
+static size_t gc_allocated=0;     // bytes since last collection
+static size_t gc_trigger=GC_MIN_TRIGGER;
+static size_t gc_live=0;
+static uint64_t gc_count=0;
+static uint64_t gc_pause_total=0;
+static uint64_t gc_pause_max=0;
+static uintptr_t *gc_stack=NULL;  // mark stack of (start, size) pairs
+static size_t gc_stack_len=0;
+static size_t gc_stack_cap=0;
+
+static void gc_stats(){
+	fprintf(stderr,"gc: %llu collections, pause total %.3f ms, max %.3f ms, "
+		"heap %zu KiB\n", (unsigned long long)gc_count,
+		gc_pause_total/1e6, gc_pause_max/1e6, gc_top*GC_PAGE/1024);
+}
+
+static void gc_init(){
+	gc_base=mmap(NULL, GC_RESERVE, PROT_READ|PROT_WRITE,
+		MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+	gc_pages=mmap(NULL, (GC_RESERVE/GC_PAGE)*sizeof(struct gc_page),
+		PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+	if(gc_base==MAP_FAILED || gc_pages==MAP_FAILED){
+		fprintf(stderr,"Cannot reserve garbage collected heap\n");
+		exit(1);
+	}
+	if(getenv("PCL_GC_STATS")) atexit(gc_stats);
+}
+
+static size_t gc_new_run(size_t n){
+	/* first fit among free pages, else pages never used. The scan
+	 * starts at the lowest free page, so taking single pages between
+	 * collections costs O(pages) in total. */
+	size_t start=0, len=0, lowest=SIZE_MAX;
+	for(size_t i=gc_free_hint; i<gc_top; i++){
+		if(gc_pages[i].obj_size){
+			len=0;
+			continue;
+		}
+		if(lowest==SIZE_MAX) lowest=i;
+		if(!len) start=i;
+		if(++len==n){
+			gc_free_hint= lowest==start ? start+n : lowest;
+			return start;
+		}
+	}
+	// a free run at the top is extended.
+	if(!len) start=gc_top;
+	if(start+n>GC_RESERVE/GC_PAGE){
+		fprintf(stderr,"Out of memory\n");
+		exit(1);
+	}
+	gc_top=start+n;
+	gc_free_hint= lowest<start ? lowest : gc_top;
+	return start;
+}
+
+static void gc_free_run(size_t first, size_t n){
+	madvise(gc_base+first*GC_PAGE, n*GC_PAGE, MADV_DONTNEED);
+	memset(gc_pages+first, 0, n*sizeof(struct gc_page));
+	if(first<gc_free_hint) gc_free_hint=first;
+}
+
+static void gc_push(uintptr_t start, size_t size){
+	if(gc_stack_len+2>gc_stack_cap){
+		gc_stack_cap= gc_stack_cap ? 2*gc_stack_cap : 4096;
+		gc_stack=realloc(gc_stack, gc_stack_cap*sizeof(*gc_stack));
+		if(!gc_stack){
+			fprintf(stderr,"Out of memory\n");
+			exit(1);
+		}
+	}
+	gc_stack[gc_stack_len++]=start;
+	gc_stack[gc_stack_len++]=size;
+}
+
+static void gc_mark_word(uintptr_t w){
+	if(w<(uintptr_t)gc_base || w>=(uintptr_t)gc_base+gc_top*GC_PAGE) return;
+	size_t i=(w-(uintptr_t)gc_base)>>GC_PAGE_BITS;
+	struct gc_page *pg=gc_pages+i;
+	if(!pg->obj_size) return;
+	if(pg->run){
+		// large object; bookkeeping is on its first page.
+		pg=gc_pages+pg->first;
+		if(!(pg->alloc[0]&1) || (pg->mark[0]&1)) return;
+		pg->mark[0]|=1;
+		gc_push((uintptr_t)gc_base+(pg-gc_pages)*GC_PAGE, pg->obj_size);
+		return;
+	}
+	uintptr_t page=(uintptr_t)gc_base+i*GC_PAGE;
+	size_t k=(w-page)/pg->obj_size;
+	if((k+1)*pg->obj_size>GC_PAGE) return;
+	size_t slot=k*pg->obj_size/GC_GRAIN;
+	uint64_t bit=1ULL<<(slot%64);
+	if(!(pg->alloc[slot/64]&bit) || (pg->mark[slot/64]&bit)) return;
+	pg->mark[slot/64]|=bit;
+	gc_push(page+k*pg->obj_size, pg->obj_size);
+}
+
+static void gc_mark_range(const void *lo, const void *hi){
+	uintptr_t a=((uintptr_t)lo+sizeof(void*)-1)&~(uintptr_t)(sizeof(void*)-1);
+	for(; a+sizeof(void*)<=(uintptr_t)hi; a+=sizeof(void*)){
+		gc_mark_word(*(uintptr_t*)a);
+	}
+}
+
+static void gc_sweep(){
+	for(size_t c=0; c<GC_CLASSES; c++){
+		// partly used pages are swept like the others.
+		gc_classes[c].bump=gc_classes[c].bump_end=NULL;
+		gc_classes[c].free=NULL;
+	}
+	gc_live=0;
+	for(size_t i=gc_top; i-->0; ){
+		struct gc_page *pg=gc_pages+i;
+		if(!pg->obj_size) continue;
+		if(pg->run){
+			if(pg->first!=i) continue;
+			if(pg->mark[0]&1){
+				pg->mark[0]=0;
+				gc_live+=pg->run*GC_PAGE;
+			}
+			else{
+				gc_free_run(i, pg->run);
+			}
+			continue;
+		}
+		char *page=gc_base+i*GC_PAGE;
+		size_t size=pg->obj_size;
+		size_t n=GC_PAGE/size;
+		pg->live=0;
+		for(size_t w=0; w<GC_SLOTS/64; w++){
+			pg->alloc[w]&=pg->mark[w];
+			pg->live+=__builtin_popcountll(pg->alloc[w]);
+			pg->mark[w]=0;
+		}
+		if(!pg->live){
+			gc_free_run(i, 1);
+			continue;
+		}
+		gc_live+=pg->live*size;
+		struct gc_class *cls=gc_classes+size/GC_GRAIN-1;
+		for(size_t k=n; k-->0; ){
+			size_t slot=k*size/GC_GRAIN;
+			if(pg->alloc[slot/64]&(1ULL<<(slot%64))) continue;
+			// free slots are cleared so they hold no stale pointers.
+			char *p=page+k*size;
+			memset(p, 0, size);
+			*(void**)p=cls->free;
+			cls->free=p;
+		}
+	}
+}
+
+__attribute__((noinline))
+static void *gc_stack_low(){
+	// below every frame of its caller (including saved registers).
+	return __builtin_frame_address(0);
+}
+
+__attribute__((noinline))
+static void gc_collect(){
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	/* callee-saved registers are spilled to this frame unmangled (setjmp
+	 * would mangle rbp/rsp in its jmp_buf); caller-saved ones were
+	 * spilled by the callers. */
+	__builtin_unwind_init();
+	gc_mark_range(gc_stack_low(), __libc_stack_end);
+	gc_mark_range(__data_start, _end);
+	while(gc_stack_len){
+		size_t size=gc_stack[--gc_stack_len];
+		uintptr_t start=gc_stack[--gc_stack_len];
+		gc_mark_range((void*)start, (void*)(start+size));
+	}
+	gc_sweep();
+	gc_allocated=0;
+	gc_trigger= gc_live>GC_MIN_TRIGGER ? gc_live : GC_MIN_TRIGGER;
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	uint64_t pause=(t1.tv_sec-t0.tv_sec)*1000000000ULL+t1.tv_nsec-t0.tv_nsec;
+	gc_count++;
+	gc_pause_total+=pause;
+	if(pause>gc_pause_max) gc_pause_max=pause;
+}
+
+static void *gc_alloc_large(size_t size){
+	size_t n=(size+GC_PAGE-1)/GC_PAGE;
+	size_t first=gc_new_run(n);
+	for(size_t i=first; i<first+n; i++){
+		gc_pages[i].obj_size=size;
+		gc_pages[i].run=n;
+		gc_pages[i].first=first;
+	}
+	gc_pages[first].alloc[0]=1;
+	return gc_base+first*GC_PAGE;
+}
+
+void *pcl_gc_alloc(int64_t size){
+	if(!gc_base) gc_init();
+	if(size<=0) size=1;
+	size=(size+GC_GRAIN-1)/GC_GRAIN*GC_GRAIN;
+	if(gc_allocated>gc_trigger) gc_collect();
+	gc_allocated+=size;
+	if(size>GC_SMALL_MAX) return gc_alloc_large(size);
+	struct gc_class *cls=gc_classes+size/GC_GRAIN-1;
+	char *p;
+	if(cls->bump+size<=cls->bump_end && cls->bump){
+		p=cls->bump;
+		cls->bump+=size;
+	}
+	else if(cls->free){
+		p=cls->free;
+		cls->free=*(void**)p;
+		*(void**)p=NULL;
+	}
+	else{
+		size_t i=gc_new_run(1);
+		gc_pages[i].obj_size=size;
+		p=gc_base+i*GC_PAGE;
+		cls->bump=p+size;
+		cls->bump_end=p+GC_PAGE/size*size;
+	}
+	size_t i=(p-gc_base)>>GC_PAGE_BITS;
+	size_t slot=(p-(gc_base+i*GC_PAGE))/GC_GRAIN;
+	gc_pages[i].alloc[slot/64]|=1ULL<<(slot%64);
+	return p;
+}
+
+
+/* '--check-bounds' */
+void pcl_bounds_error(int32_t index, int32_t size, int32_t line){
+	out_flush();
+	fprintf(stderr,"Line %d: array index %d out of bounds (size %d)\n",
+		line, index, size);
+	exit(1);
+}
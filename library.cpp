@@ -57,6 +57,48 @@ writeString::writeString():Procedure (
 }
 
 
+writeIntegerArray::writeIntegerArray():Procedure (
+	"writeIntegerArray",
+	new DeclList(
+			new Decl("n")
+	),
+	new Body(true )
+){
+		formals->toFormal(INTEGER::getInstance(),false);
+		DeclList* d=new DeclList(new Decl("a"));
+		TSPtr arrT(new ArrType(INTEGER::getInstance()));
+		d->toFormal(arrT,true);
+		formals->merge(d);
+}
+
+writeRealArray::writeRealArray():Procedure (
+	"writeRealArray",
+	new DeclList(
+			new Decl("n")
+	),
+	new Body(true )
+){
+		formals->toFormal(INTEGER::getInstance(),false);
+		DeclList* d=new DeclList(new Decl("a"));
+		TSPtr arrT(new ArrType(REAL::getInstance()));
+		d->toFormal(arrT,true);
+		formals->merge(d);
+}
+
+writeCharArray::writeCharArray():Procedure (
+	"writeCharArray",
+	new DeclList(
+			new Decl("n")
+	),
+	new Body(true )
+){
+		formals->toFormal(INTEGER::getInstance(),false);
+		DeclList* d=new DeclList(new Decl("a"));
+		TSPtr arrT(new ArrType(CHARACTER::getInstance()));
+		d->toFormal(arrT,true);
+		formals->merge(d);
+}
+
 //----read subprograms------------
 
 readInteger::readInteger():Function (
@@ -102,6 +144,48 @@ readString::readString():Procedure (
 		formals->merge(d);
 }
 
+readIntegerArray::readIntegerArray():Procedure (
+	"readIntegerArray",
+	new DeclList(
+			new Decl("n")
+	),
+	new Body(true )
+){
+		formals->toFormal(INTEGER::getInstance(),false);
+		DeclList* d=new DeclList(new Decl("a"));
+		TSPtr arrT(new ArrType(INTEGER::getInstance()));
+		d->toFormal(arrT,true);
+		formals->merge(d);
+}
+
+readRealArray::readRealArray():Procedure (
+	"readRealArray",
+	new DeclList(
+			new Decl("n")
+	),
+	new Body(true )
+){
+		formals->toFormal(INTEGER::getInstance(),false);
+		DeclList* d=new DeclList(new Decl("a"));
+		TSPtr arrT(new ArrType(REAL::getInstance()));
+		d->toFormal(arrT,true);
+		formals->merge(d);
+}
+
+readCharArray::readCharArray():Procedure (
+	"readCharArray",
+	new DeclList(
+			new Decl("n")
+	),
+	new Body(true )
+){
+		formals->toFormal(INTEGER::getInstance(),false);
+		DeclList* d=new DeclList(new Decl("a"));
+		TSPtr arrT(new ArrType(CHARACTER::getInstance()));
+		d->toFormal(arrT,true);
+		formals->merge(d);
+}
+
 //-------math functions--------
 
 abs_pcl::abs_pcl():Function (
@@ -111,6 +195,7 @@ abs_pcl::abs_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(INTEGER::getInstance(),false);
+	toPure();
 }
 
 
@@ -121,6 +206,7 @@ fabs_pcl::fabs_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(REAL::getInstance(),false);
+	toPure();
 }
 
 sqrt_pcl::sqrt_pcl():Function (
@@ -130,6 +216,7 @@ sqrt_pcl::sqrt_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(REAL::getInstance(),false);
+	toPure();
 }
 
 sin_pcl::sin_pcl():Function (
@@ -139,6 +226,7 @@ sin_pcl::sin_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(REAL::getInstance(),false);
+	toPure();
 }
 
 cos_pcl::cos_pcl():Function (
@@ -148,6 +236,7 @@ cos_pcl::cos_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(REAL::getInstance(),false);
+	toPure();
 }
 
 tan_pcl::tan_pcl():Function (
@@ -157,6 +246,7 @@ tan_pcl::tan_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(REAL::getInstance(),false);
+	toPure();
 }
 
 
@@ -167,6 +257,7 @@ arctan_pcl::arctan_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(REAL::getInstance(),false);
+	toPure();
 }
 
 
@@ -177,6 +268,7 @@ exp_pcl::exp_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(REAL::getInstance(),false);
+	toPure();
 }
 
 ln_pcl::ln_pcl():Function (
@@ -186,6 +278,7 @@ ln_pcl::ln_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(REAL::getInstance(),false);
+	toPure();
 }
 
 pi_pcl::pi_pcl():Function (
@@ -193,7 +286,9 @@ pi_pcl::pi_pcl():Function (
 	new DeclList(),
 	REAL::getInstance(),
 	new Body(true)
-){}
+){
+	toPure();
+}
 
 
 
@@ -205,6 +300,7 @@ trunc_pcl::trunc_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(REAL::getInstance(),false);
+	toPure();
 }
 
 
@@ -216,6 +312,7 @@ round_pcl::round_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(REAL::getInstance(),false);
+	toPure();
 }
 
 
@@ -227,6 +324,7 @@ ord_pcl::ord_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(CHARACTER::getInstance(),false);
+	toPure();
 }
 
 
@@ -238,6 +336,90 @@ chr_pcl::chr_pcl():Function (
 	new Body(true)
 ){
 	formals->toFormal(INTEGER::getInstance(),false);
+	toPure();
+}
+
+length_pcl::length_pcl():Function (
+	"length",
+	new DeclList(new Decl("a")),
+	INTEGER::getInstance(),
+	new Body(true)
+){
+	// number of elements of any array (dynamic arrays carry it).
+	TSPtr arrT(new ArrType(ANY::getInstance()));
+	formals->toFormal(arrT,true);
+	toPure();
+}
+
+countTrue::countTrue():Function (
+	"countTrue",
+	new DeclList(new Decl("a")),
+	INTEGER::getInstance(),
+	new Body(true)
+){
+	// number of elements of a packed array that are true.
+	TSPtr arrT(new PackedArrType(-1));
+	formals->toFormal(arrT,true);
+	toReadOnly();
+}
+
+fillBoolean::fillBoolean():Procedure (
+	"fillBoolean",
+	new DeclList(new Decl("a")),
+	new Body(true)
+){
+	// sets every element of a packed array to 'b'.
+	TSPtr arrT(new PackedArrType(-1));
+	formals->toFormal(arrT,true);
+	DeclList* d=new DeclList(new Decl("b"));
+	d->toFormal(BOOLEAN::getInstance(),false);
+	formals->merge(d);
+}
+
+//-------file mapping--------
+
+mapFile::mapFile():Function (
+	"mapFile",
+	new DeclList(new Decl("name")),
+	INTEGER::getInstance(),
+	new Body(true)
+){
+	// maps file 'name' read-only to 'p'; returns its size or -1.
+	TSPtr arrT(new ArrType(CHARACTER::getInstance()));
+	formals->toFormal(arrT,true);
+	DeclList* d=new DeclList(new Decl("p"));
+	TSPtr ptrT(new PtrType(TSPtr(new ArrType(CHARACTER::getInstance()))));
+	d->toFormal(ptrT,true);
+	formals->merge(d);
+}
+
+mapNewFile::mapNewFile():Function (
+	"mapNewFile",
+	new DeclList(new Decl("name")),
+	INTEGER::getInstance(),
+	new Body(true)
+){
+	// creates file 'name' of 'size' bytes mapped writable to 'p';
+	//   returns size or -1.
+	TSPtr arrT(new ArrType(CHARACTER::getInstance()));
+	formals->toFormal(arrT,true);
+	DeclList* d=new DeclList(new Decl("size"));
+	d->toFormal(INTEGER::getInstance(),false);
+	formals->merge(d);
+	d=new DeclList(new Decl("p"));
+	TSPtr ptrT(new PtrType(TSPtr(new ArrType(CHARACTER::getInstance()))));
+	d->toFormal(ptrT,true);
+	formals->merge(d);
+}
+
+unmapFile::unmapFile():Procedure (
+	"unmapFile",
+	new DeclList(new Decl("p")),
+	new Body(true)
+){
+	// unmaps (and writes back) a mapped file; p becomes nil.
+	TSPtr ptrT(new PtrType(TSPtr(new ArrType(CHARACTER::getInstance()))));
+	formals->toFormal(ptrT,true);
 }
 
 std::vector<Procedure*> library_subprograms{
@@ -246,11 +428,17 @@ std::vector<Procedure*> library_subprograms{
 	writeChar::getInstance(),
 	writeReal::getInstance(),
 	writeString::getInstance(),
+	writeIntegerArray::getInstance(),
+	writeRealArray::getInstance(),
+	writeCharArray::getInstance(),
 	readInteger::getInstance(),
 	readBoolean::getInstance(),
 	readChar::getInstance(),
 	readReal::getInstance(),
 	readString::getInstance(),
+	readIntegerArray::getInstance(),
+	readRealArray::getInstance(),
+	readCharArray::getInstance(),
 	abs_pcl::getInstance(),
 	fabs_pcl::getInstance(),
 	sqrt_pcl::getInstance(),
@@ -264,5 +452,11 @@ std::vector<Procedure*> library_subprograms{
 	trunc_pcl::getInstance(),
 	round_pcl::getInstance(),
 	ord_pcl::getInstance(),
-	chr_pcl::getInstance()
+	chr_pcl::getInstance(),
+	length_pcl::getInstance(),
+	countTrue::getInstance(),
+	fillBoolean::getInstance(),
+	mapFile::getInstance(),
+	mapNewFile::getInstance(),
+	unmapFile::getInstance()
 };
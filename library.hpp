@@ -53,6 +53,36 @@ public:
 	}
 };
 
+class writeIntegerArray: public Procedure{
+private:
+	writeIntegerArray();
+public:
+	static writeIntegerArray* getInstance(){
+		static writeIntegerArray instance;
+		return &instance;
+	}
+};
+
+class writeRealArray: public Procedure{
+private:
+	writeRealArray();
+public:
+	static writeRealArray* getInstance(){
+		static writeRealArray instance;
+		return &instance;
+	}
+};
+
+class writeCharArray: public Procedure{
+private:
+	writeCharArray();
+public:
+	static writeCharArray* getInstance(){
+		static writeCharArray instance;
+		return &instance;
+	}
+};
+
 //----read subprograms------------
 
 class readInteger: public Function{
@@ -106,6 +136,36 @@ public:
 	}
 };
 
+class readIntegerArray: public Procedure{
+private:
+	readIntegerArray();
+public:
+	static readIntegerArray* getInstance(){
+		static readIntegerArray instance;
+		return &instance;
+	}
+};
+
+class readRealArray: public Procedure{
+private:
+	readRealArray();
+public:
+	static readRealArray* getInstance(){
+		static readRealArray instance;
+		return &instance;
+	}
+};
+
+class readCharArray: public Procedure{
+private:
+	readCharArray();
+public:
+	static readCharArray* getInstance(){
+		static readCharArray instance;
+		return &instance;
+	}
+};
+
 //-------math functions--------
 
 
@@ -275,5 +335,68 @@ public:
 	}
 };
 
+class length_pcl: public Function{
+private:
+	length_pcl();
+public:
+	static length_pcl* getInstance(){
+		static length_pcl instance;
+		return &instance;
+	}
+};
+
+class countTrue: public Function{
+private:
+	countTrue();
+public:
+	static countTrue* getInstance(){
+		static countTrue instance;
+		return &instance;
+	}
+};
+
+class fillBoolean: public Procedure{
+private:
+	fillBoolean();
+public:
+	static fillBoolean* getInstance(){
+		static fillBoolean instance;
+		return &instance;
+	}
+};
+
+
+//-------file mapping--------
+
+class mapFile: public Function{
+private:
+	mapFile();
+public:
+	static mapFile* getInstance(){
+		static mapFile instance;
+		return &instance;
+	}
+};
+
+class mapNewFile: public Function{
+private:
+	mapNewFile();
+public:
+	static mapNewFile* getInstance(){
+		static mapNewFile instance;
+		return &instance;
+	}
+};
+
+class unmapFile: public Procedure{
+private:
+	unmapFile();
+public:
+	static unmapFile* getInstance(){
+		static unmapFile instance;
+		return &instance;
+	}
+};
+
 
 //---------transformation functions------
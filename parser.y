@@ -15,12 +15,24 @@ Syntax parser for pcl compiler in bison.
 	extern char msg[100];
 	extern char linebuf[500];
 	extern struct symbol_loc location;
+	extern const char *runtime_bc;
+	extern bool gc_heap;
+	extern bool check_bounds;
 }
 
 %code{
 	char msg[100];
 	char linebuf[500];
 	struct symbol_loc location{1,0,1,0};
+
+	static LValue* index_chain(LValue* l, ExprList* idx){
+		// a[i, j] is a[i][j].
+		for(uint i=0; i<idx->size(); i++){
+			l = new Brackets(l, (*idx)[i]);
+			l->add_parse_info(location, linebuf);
+		}
+		return l;
+	}
 }
 
 %define parse.error verbose
@@ -34,6 +46,7 @@ Syntax parser for pcl compiler in bison.
 %token T_real "real"
 %token T_array "array"
 %token T_of "of"
+%token T_packed "packed"
 %token T_program "program"
 %token T_procedure "procedure"
 %token T_forward "forward"
@@ -45,6 +58,11 @@ Syntax parser for pcl compiler in bison.
 %token T_else "else"
 %token T_while "while"
 %token T_do "do"
+%token T_for "for"
+%token T_to "to"
+%token T_downto "downto"
+%token T_case "case"
+%token T_const "const"
 %token T_goto "goto"
 %token T_label "label"
 %token T_return "return"
@@ -89,6 +107,11 @@ Syntax parser for pcl compiler in bison.
 	Expr* expr;
 	TSPtr* type;
 	LValue* lvalue;
+	Id* id;
+	CaseArm* caseArm;
+	Initializer* init;
+	List<Initializer>* inits;
+	List<CaseArm>* caseArms;
 	std::string* var;
 	int numi;
 	double numd;
@@ -97,12 +120,18 @@ Syntax parser for pcl compiler in bison.
 %type<program> program;
 %type<body> body
 %type<stmtList> block mult_stmts
-%type<declList> mult_locals local var_decl mult_ids args mult_formals formal
-%type<exprList> params mult_exprs
+%type<declList> mult_locals local var_decl const_decl mult_ids args mult_formals formal
+%type<exprList> params mult_exprs indices case_labels
 %type<stmt> stmt proc_call
-%type<expr> expr r_value fun_call
+%type<expr> expr r_value fun_call case_label const_value
 %type<lvalue> l_value_ref l_value
+%type<id> for_counter
+%type<caseArm> case_arm
+%type<caseArms> case_arms
+%type<init> initializer
+%type<inits> init_items
 %type<type> type full_type
+%type<numi> rank
 %type<proc> header
 %%
 
@@ -130,6 +159,7 @@ mult_locals:
 
 local:
   "var" var_decl {$$ = $2;}
+| "const" const_decl {$$ = $2;}
 | "label" mult_ids ';' {$2->toLabel(); $$=$2;}
 | header ';' body ';' {$1->add_body($3); $$=new DeclList($1);$$->add_parse_info(location, linebuf);}
 | "forward" header ';' {$2->toForward();$$ = new DeclList($2);$$->add_parse_info(location, linebuf);}
@@ -137,12 +167,43 @@ local:
 
 var_decl:
   mult_ids ':' type ';' {$1->toVar(*$3); $$ = $1;}
+| mult_ids ':' type '=' initializer ';' {$1->toVar(*$3, $5); $$ = $1;}
 | var_decl mult_ids ':' type ';' {$2->toVar(*$4); $1->merge($2); $$=$1;}
+| var_decl mult_ids ':' type '=' initializer ';' {$2->toVar(*$4, $6); $1->merge($2); $$=$1;}
+;
+
+initializer:
+  '(' init_items ')' {$$ = new Initializer($2);$$->add_parse_info(location, linebuf);}
+| T_sconst {$$ = new Initializer(*$1);$$->add_parse_info(location, linebuf);}
+| const_value {$$ = new Initializer($1);$$->add_parse_info(location, linebuf);}
+;
+
+init_items:
+  initializer {$$ = new List<Initializer>($1);}
+| init_items ',' initializer {$1->append($3); $$=$1;}
+;
+
+const_decl:
+  T_id '=' const_value ';' {$$ = new DeclList(new ConstDecl(new Decl(*$1), $3));$$->add_parse_info(location, linebuf);}
+| const_decl T_id '=' const_value ';' {$1->append(new ConstDecl(new Decl(*$2), $4)); $$=$1;}
+;
+
+const_value:
+  T_iconst {$$ = new Iconst($1);$$->add_parse_info(location, linebuf);}
+| '-' T_iconst {$$ = new Iconst(-$2);$$->add_parse_info(location, linebuf);}
+| T_rconst {$$ = new Rconst($1);$$->add_parse_info(location, linebuf);}
+| '-' T_rconst {$$ = new Rconst(-$2);$$->add_parse_info(location, linebuf);}
+| T_cconst {$$ = new Cconst($1);$$->add_parse_info(location, linebuf);}
+| "true" {$$ = new Bconst(true);$$->add_parse_info(location, linebuf);}
+| "false" {$$ = new Bconst(false);$$->add_parse_info(location, linebuf);}
+| T_id {$$ = new Id(*$1);$$->add_parse_info(location, linebuf);}
 ;
 
 mult_ids:
-  T_id { $$ = new DeclList(new Decl(*$1));$$->add_parse_info(location, linebuf);}
-| mult_ids ',' T_id {$1->append(new Decl(*$3)); $$=$1;}
+  T_id { Decl* d = new Decl(*$1);d->add_parse_info(location, linebuf);
+	$$ = new DeclList(d);$$->add_parse_info(location, linebuf);}
+| mult_ids ',' T_id {Decl* d = new Decl(*$3);d->add_parse_info(location, linebuf);
+	$1->append(d); $$=$1;}
 ;
 
 type:
@@ -151,16 +212,29 @@ type:
 | "boolean" {$$ = BOOLEAN::getPtrInstance(); }
 | "char" {$$ = CHARACTER::getPtrInstance(); }
 | "array" '[' T_iconst ']' "of" full_type {$$ = new TSPtr(new ArrType($3,*$6));}
+| "array" '[' T_id ']' "of" full_type {$$ = new TSPtr(new ArrType(*$3,*$6));}
 | "array" "of" full_type {$$ = new TSPtr( new ArrType(*$3));}
+| "array" '[' rank ']' "of" full_type {$$ = new TSPtr( new MultiArrType($3,*$6));}
+| "packed" "array" '[' T_iconst ']' "of" "boolean" {$$ = new TSPtr(new PackedArrType($4));}
+| "packed" "array" '[' T_id ']' "of" "boolean" {$$ = new TSPtr(new PackedArrType(*$4));}
+| "packed" "array" "of" "boolean" {$$ = new TSPtr(new PackedArrType(-1));}
 | '^' type {$$ = new TSPtr(new PtrType(*$2));}
 ;
 
+rank:
+  ',' {$$ = 2;}
+| rank ',' {$$ = $1+1;}
+;
+
 full_type:
 "integer" {$$= INTEGER::getPtrInstance();}
 | "real"  {$$ = REAL::getPtrInstance(); }
 | "boolean" {$$ = BOOLEAN::getPtrInstance(); }
 | "char" {$$ = CHARACTER::getPtrInstance(); }
 | "array" '[' T_iconst ']' "of" full_type {$$ = new TSPtr(new ArrType($3,*$6));}
+| "array" '[' T_id ']' "of" full_type {$$ = new TSPtr(new ArrType(*$3,*$6));}
+| "packed" "array" '[' T_iconst ']' "of" "boolean" {$$ = new TSPtr(new PackedArrType($4));}
+| "packed" "array" '[' T_id ']' "of" "boolean" {$$ = new TSPtr(new PackedArrType(*$4));}
 | '^' full_type {$$ = new TSPtr (new PtrType(*$2));}
 ;
 
@@ -201,15 +275,49 @@ stmt:
 | "if" expr "then" stmt "else" stmt {$$ = new If($2,$4,$6);$$->add_parse_info(location, linebuf);}
 | "if" expr "then" stmt {$$ = new If($2,$4,nullptr);$$->add_parse_info(location, linebuf);}
 | "while" expr "do" stmt {$$ = new While($2, $4);$$->add_parse_info(location, linebuf);}
+| "for" for_counter ":=" expr "to" expr "do" stmt {$$ = new For($2, $4, $6, $8, false);$$->add_parse_info(location, linebuf);}
+| "for" for_counter ":=" expr "downto" expr "do" stmt {$$ = new For($2, $4, $6, $8, true);$$->add_parse_info(location, linebuf);}
+| "case" expr "of" case_arms "end" {$$ = new Case($2, $4, nullptr);$$->add_parse_info(location, linebuf);}
+| "case" expr "of" case_arms ';' "end" {$$ = new Case($2, $4, nullptr);$$->add_parse_info(location, linebuf);}
+| "case" expr "of" case_arms "else" stmt "end" {$$ = new Case($2, $4, $6);$$->add_parse_info(location, linebuf);}
+| "case" expr "of" case_arms ';' "else" stmt "end" {$$ = new Case($2, $4, $7);$$->add_parse_info(location, linebuf);}
 | T_id ':' stmt { $$=new LabelStmt(*$1, $3);$$->add_parse_info(location, linebuf);}
 | "goto" T_id { $$ = new Goto(*$2);$$->add_parse_info(location, linebuf);}
 | "return" {$$ = new Return();$$->add_parse_info(location, linebuf);}
 | "new" '[' expr ']' l_value {$$ = new New($5,$3);$$->add_parse_info(location, linebuf);}
-| "new" l_value {$$=new New($2,nullptr);$$->add_parse_info(location, linebuf);}
+| "new" '[' indices ']' l_value {$$ = new New($5,$3);$$->add_parse_info(location, linebuf);}
+| "new" l_value {$$=new New($2,(Expr*)nullptr);$$->add_parse_info(location, linebuf);}
 | "dispose" '[' ']' l_value {$$ = new DisposeArr($4);$$->add_parse_info(location, linebuf);}
 | "dispose" l_value {$$ = new Dispose($2);$$->add_parse_info(location, linebuf);}
 ;
 
+case_arms:
+  case_arm {$$ = new List<CaseArm>($1);}
+| case_arms ';' case_arm {$1->append($3); $$=$1;}
+;
+
+case_arm:
+  case_labels ':' stmt {$$ = new CaseArm($1, $3);$$->add_parse_info(location, linebuf);}
+;
+
+case_labels:
+  case_label {$$ = new ExprList($1);}
+| case_labels ',' case_label {$1->append($3); $$=$1;}
+;
+
+case_label:
+  T_iconst {$$ = new Iconst($1);$$->add_parse_info(location, linebuf);}
+| '-' T_iconst {$$ = new Iconst(-$2);$$->add_parse_info(location, linebuf);}
+| T_cconst {$$ = new Cconst($1);$$->add_parse_info(location, linebuf);}
+| "true" {$$ = new Bconst(true);$$->add_parse_info(location, linebuf);}
+| "false" {$$ = new Bconst(false);$$->add_parse_info(location, linebuf);}
+| T_id {$$ = new Id(*$1);$$->add_parse_info(location, linebuf);}
+;
+
+for_counter:
+  T_id {$$ = new Id(*$1);$$->add_parse_info(location, linebuf);}
+;
+
 expr:
   l_value {$$ = $1;}
 | r_value {$$ = $1;}
@@ -219,6 +327,7 @@ l_value_ref:
 | "result" {$$ = new Id("result");$$->add_parse_info(location, linebuf);}
 | T_sconst {$$ = new Sconst(*$1);$$->add_parse_info(location, linebuf);}
 | l_value_ref '[' expr ']' %prec BRACKETS {$$ = new Brackets($1,$3);$$->add_parse_info(location, linebuf);}
+| l_value_ref '[' indices ']' %prec BRACKETS {$$ = index_chain($1,$3);}
 | '(' l_value ')' {$$ = $2;}
 
 l_value:
@@ -227,6 +336,7 @@ l_value:
 | "result" {$$ = new Id("result");$$->add_parse_info(location, linebuf);}
 | T_sconst {$$ = new Sconst(*$1);$$->add_parse_info(location, linebuf);}
 | l_value '[' expr ']' %prec BRACKETS {$$ = new Brackets($1,$3);$$->add_parse_info(location, linebuf);}
+| l_value '[' indices ']' %prec BRACKETS {$$ = index_chain($1,$3);}
 | '(' l_value ')'{$$ = $2;}
 ;
 
@@ -272,6 +382,11 @@ params:
 |mult_exprs {$$ = $1;}
 ;
 
+indices:
+  expr ',' expr {$$ = new ExprList($1); $$->append($3);}
+| indices ',' expr {$1->append($3); $$ = $1;}
+;
+
 mult_exprs:
   expr {$$ = new ExprList($1);$$->add_parse_info(location, linebuf);}
 | mult_exprs ',' expr { $1->append($3); $$ = $1;}
@@ -280,7 +395,27 @@ mult_exprs:
 %%
 
 
-int main() {
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--runtime") and i + 1 < argc) {
+      // runtime library bitcode to link into the program.
+      runtime_bc = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--gc")) {
+      // garbage collected heap for 'new'.
+      gc_heap = true;
+    }
+    else if (!strcmp(argv[i], "--check-bounds")) {
+      // runtime check of array indices.
+      check_bounds = true;
+    }
+    else {
+      std::cerr << "Usage: " << argv[0]
+        << " [--runtime <lib.bc>] [--gc] [--check-bounds] < file.pcl"
+        << std::endl;
+      return 1;
+    }
+  }
   int result = yyparse();
   return result;
 }
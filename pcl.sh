@@ -4,9 +4,10 @@ file_path=""
 asm_out=false
 ir_out=false
 opt_flag=-O0
+pcl_flags=""
 DIR=$(pwd)
 pcl_compiler=$DIR/pcl
-LIB_OBJ=$DIR/lib.o
+LIB_BC=$DIR/lib.bc
 TEMP=_pcl_temp
 mtriple=$(clang -dumpmachine)
 while [[ $# -gt 0 ]];
@@ -19,6 +20,8 @@ do
         -O)   opt_flag=-O2;;
         -i)   ir_out=true;;
         -f)   asm_out=true;;
+        --gc) pcl_flags="${pcl_flags} --gc";;
+        --check-bounds) pcl_flags="${pcl_flags} --check-bounds";;
         -*)   ;;
         *)    file_path="$1"
     esac
@@ -43,11 +46,11 @@ elif [[ ${asm_out} = true ]]; then
    llc_out="${TEMP}.asm"
    llc_params="-mtriple=${mtriple} -o"
    clang_inp="${TEMP}.asm"
-   clang_params="$LIB_OBJ -lm -o"
+   clang_params="-lm -o"
    clang_out="/dev/stdout"
 else
   if [[ -z ${file_path} ]]; then
-    echo "Usage: $0 [-O|-O0|-O1|O2|O3] -i|-f|<filename>"
+    echo "Usage: $0 [-O|-O0|-O1|O2|O3] [--gc] [--check-bounds] -i|-f|<filename>"
     exit 1;
   fi
   echo "Compiling ${file_path}"
@@ -61,15 +64,15 @@ else
   llc_params="-mtriple=${mtriple} -o"
   llc_out="${TEMP}.asm"
   clang_inp="${TEMP}.asm"
-  clang_params="$LIB_OBJ -lm -o"
+  clang_params="-lm -o"
   clang_out="${file_name}"
 fi
 
-if ! $pcl_compiler < ${to_llvm_inp} > ${to_llvm_out}; then
+if ! $pcl_compiler --runtime $LIB_BC ${pcl_flags} < ${to_llvm_inp} > ${to_llvm_out}; then
    echo "Error in compilation to llvm."
    exit 1
 fi
-if ! opt ${opt_flag} $opt_inp $opt_params $opt_out; then
+if ! opt -mtriple=${mtriple} ${opt_flag} $opt_inp $opt_params $opt_out; then
    echo "Error in llvm optimization."
    exit 1
 fi
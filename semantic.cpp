@@ -7,6 +7,74 @@ Contains member functions that are used in
 #include "symbol.hpp"
 #include "library.hpp"
 
+static void mark_captured(LValue* lval){
+ /* address of lval escapes; if it is a by-reference parameter
+    of the current subprogram, it can't be marked nocapture. */
+	FunctionEntry* e = st.getParentOfCurrentScope();
+	Id* root = lval->get_root();
+	if(e and root){
+		e->type->add_captured(root->get_name());
+	}
+}
+
+static void mark_addr_taken(LValue* lval){
+ /* address of lval is used; variable it is rooted at
+    can't be kept in SSA form. */
+	FunctionEntry* e = st.getParentOfCurrentScope();
+	Id* root = lval->get_root();
+	if(root and root->get_constant()){
+		std::ostringstream stream;
+		stream<<"Constant '"<<*lval<<"' has no address.";
+		lval->report_error(stream.str().c_str());
+	}
+	if(lval->is_bit()){
+		std::ostringstream stream;
+		stream<<"Element '"<<*lval<<"' of packed array has no address.";
+		lval->report_error(stream.str().c_str());
+	}
+	if(e and root){
+		e->type->add_addr_taken(root->get_name());
+	}
+}
+
+static bool is_nonlocal(std::string name){
+ /* name is storage that outlives a call of the current subprogram
+    (program-level variable, by-reference or outer argument). */
+	FunctionEntry* e = st.getParentOfCurrentScope();
+	return e and (st.isGlobal(name) or e->type->is_by_ref_param(name));
+}
+
+static bool is_caller_array(std::string name){
+ /* name is a by-value array parameter; its storage is the caller's
+    array (read in place or copied on entry). */
+	FunctionEntry* e = st.getParentOfCurrentScope();
+	return e and e->type->is_by_pointer_param(name);
+}
+
+static void add_effect(CallableType::Effect eff){
+	FunctionEntry* e = st.getParentOfCurrentScope();
+	if(e){
+		e->type->add_effect(eff);
+	}
+}
+
+static void mark_written(LValue* lval){
+	FunctionEntry* e = st.getParentOfCurrentScope();
+	Id* root = lval->get_root();
+	if(root and root->get_constant()){
+		std::ostringstream stream;
+		stream<<"Cannot assign to constant '"<<*lval<<"'.";
+		lval->report_error(stream.str().c_str());
+	}
+	if(e and root){
+		e->type->add_written(root->get_name());
+	}
+	if(!root or is_nonlocal(root->get_name())){
+		// write through pointer or to non-local storage.
+		add_effect(CallableType::WritesMemory);
+	}
+}
+
 void Id::sem(){
 	SymbolEntry *e = st.lookup(name);
 	if(!e){
@@ -17,6 +85,14 @@ void Id::sem(){
 		exit(1);
 	}
 	type = e->type;
+	if(e->value){
+		// named constant; stands for its literal.
+		constant = e->value;
+		return;
+	}
+	if(is_nonlocal(name) or is_caller_array(name)){
+		add_effect(CallableType::ReadsMemory);
+	}
 }
 
 void Op::sem(){
@@ -131,6 +207,11 @@ void Reference::sem(){
 		lvalue=static_cast<LValue*>(e);
 	}
 	lvalue->sem();
+	mark_addr_taken(lvalue);
+	if(count){
+		// true reference; address may be stored anywhere.
+		mark_captured(lvalue);
+	}
 }
 
 
@@ -141,6 +222,14 @@ void Dereference::sem(){
 		expr=e;
 	}
 	expr->sem();
+	if(count){
+		// true dereference reads memory of pointer.
+		add_effect(CallableType::ReadsMemory);
+	}
+	else{
+		// false dereference; address of lvalue is used.
+		mark_addr_taken(static_cast<LValue*>(expr));
+	}
 	TSPtr ty(expr->get_type());
 	if(ty->get_name().compare("pointer")){
 		std::ostringstream stream;
@@ -150,6 +239,15 @@ void Dereference::sem(){
 	}
 }
 
+Id* Dereference::get_root(){
+	if(count){
+		// true dereference; address is the value of a pointer.
+		return nullptr;
+	}
+	// false dereference; address of lvalue.
+	return static_cast<LValue*>(expr)->get_root();
+}
+
 Expr* Reference::simplify(int &count){
 	count=count-1;
 	LValue* tmp=lvalue;
@@ -195,6 +293,7 @@ void Brackets::sem(){
 void Let::sem(){
 	expr->sem();
 	lvalue->sem();
+	mark_written(lvalue);
 	TSPtr lType (lvalue->get_type());
 	TSPtr rType(expr->get_type());
 	if((rType->get_name().compare("any")) and (lType->doCompare(rType))){
@@ -261,7 +360,11 @@ bool Let::typecheck(TSPtr lType, TSPtr rType){
 			SPtr<ArrType> larrType = std::static_pointer_cast<ArrType>(linType);
 			SPtr<ArrType> rarrType = std::static_pointer_cast<ArrType>(rinType);
 			// check sizes (left must be -1, right must be >0)
-			if(rarrType->get_size()!=-1 && larrType->get_size()==-1){
+			// (and same representation, unless left is 'array of any')
+			bool same_repr = rarrType->is_packed()==larrType->is_packed()
+				or !larrType->get_type()->get_name().compare("any");
+			if(rarrType->get_size()!=-1 && larrType->get_size()==-1
+					&& same_repr){
 				// extract inner types from arrays (must be same type)
 				if(larrType->get_type()->doCompare(rarrType->get_type()))
 					return true;
@@ -300,9 +403,129 @@ void While::sem(){
 	stmt->sem();
 }
 
+void For::sem(){
+	counter->sem();
+	mark_written(counter);
+	TSPtr counter_t(counter->get_type());
+	if(!(counter_t == INTEGER::getInstance())){
+		std::ostringstream stream;
+		stream<<"Counter '"<<*counter<<
+			"' of 'for' statement should be 'integer' not '"<<*counter_t<<"'.";
+		this->report_error(stream.str().c_str());
+		exit(1);
+	}
+	for(Expr* bound: {from, to}){
+		bound->sem();
+		TSPtr bound_t(bound->get_type());
+		if(!(bound_t == INTEGER::getInstance())){
+			std::ostringstream stream;
+			stream<<"Bound '"<<*bound<<
+				"' of 'for' statement should be 'integer' not '"<<*bound_t<<"'.";
+			this->report_error(stream.str().c_str());
+			exit(1);
+		}
+	}
+	stmt->sem();
+}
+
+static int case_label_value(Expr* label){
+	// ordinal value of a (checked) literal or named constant label.
+	Id* name = dynamic_cast<Id*>(label);
+	if(name) label = name->get_constant();
+	if(Iconst* i = dynamic_cast<Iconst*>(label)) return i->get_num();
+	if(Cconst* c = dynamic_cast<Cconst*>(label)) return c->get_char();
+	return static_cast<Bconst*>(label)->get_bool();
+}
+
+void Case::sem(){
+	expr->sem();
+	TSPtr expr_t(expr->get_type());
+	if(!(expr_t == INTEGER::getInstance()) and !(expr_t == CHARACTER::getInstance())
+			and !(expr_t == BOOLEAN::getInstance())){
+		std::ostringstream stream;
+		stream<<"Expression '"<<*expr<<"' in 'case' statement should be "
+			"'integer', 'character' or 'boolean' not '"<<*expr_t<<"'.";
+		this->report_error(stream.str().c_str());
+		exit(1);
+	}
+	std::set<int> values;
+	for(uint i=0; i<arms->size(); i++){
+		CaseArm* arm = (*arms)[i];
+		for(uint j=0; j<arm->labels->size(); j++){
+			Expr* label = (*arm->labels)[j];
+			label->sem();
+			Id* name = dynamic_cast<Id*>(label);
+			if(name and !name->get_constant()){
+				std::ostringstream stream;
+				stream<<"Label '"<<*label<<"' in 'case' statement is not a constant.";
+				arm->report_error(stream.str().c_str());
+				exit(1);
+			}
+			if(!(label->get_type() == expr_t)){
+				std::ostringstream stream;
+				stream<<"Label '"<<*label<<"' in 'case' statement should be '"
+					<<*expr_t<<"' not '"<<*label->get_type()<<"'.";
+				arm->report_error(stream.str().c_str());
+				exit(1);
+			}
+			if(!values.insert(case_label_value(label)).second){
+				std::ostringstream stream;
+				stream<<"Label '"<<*label<<
+					"' appears more than once in 'case' statement.";
+				label->report_error(stream.str().c_str());
+				exit(1);
+			}
+		}
+		arm->stmt->sem();
+	}
+	if(other)
+		other->sem();
+}
+
 void New::sem(){
 	lvalue->sem();
-	if(expr){ // new array object
+	mark_written(lvalue);
+	// allocation is a side effect by itself.
+	add_effect(CallableType::WritesMemory);
+	// rank of array object (0 for non-array object).
+	int rank = dims ? dims->size() : expr ? 1 : 0;
+	TSPtr lType(lvalue->get_type());
+	if(!lType->get_name().compare("pointer")){
+		TSPtr t(std::static_pointer_cast<PtrType>(lType)->get_type());
+		int arr_rank = t->get_name().compare("array") ? 0 :
+			std::static_pointer_cast<ArrType>(t)->get_rank();
+		if((arr_rank>1 or rank>1) and arr_rank!=rank){
+			std::ostringstream stream;
+			stream<<"Lvalue '"<<*lvalue<<"' of type '"<<*lType<<
+				"' in 'new' statement can't have "<<rank<<" dimensions.";
+			this->report_error(stream.str().c_str());
+			exit(1);
+		}
+	}
+	if(dims){ // new multi-dimensional array object
+		for(uint i=0; i<dims->size(); i++){
+			Expr* d = (*dims)[i];
+			d->sem();
+			if(!(d->get_type() == INTEGER::getInstance())){
+				std::ostringstream stream;
+				stream<<"Expression '"<<*d<<
+					"' in 'new' statement should be 'integer' not '"<<
+					*d->get_type()<<"'.";
+				this->report_error(stream.str().c_str());
+				exit(1);
+			}
+		}
+		if(lType->get_name().compare("pointer") or std::static_pointer_cast<
+				PtrType>(lType)->get_type()->get_name().compare("array")){
+			std::ostringstream stream;
+			stream<<"Lvalue '"<<*lvalue<<
+				"' in 'new' statement should be '^array [,] of ..' not '"<<
+				*lType<<"'.";
+			this->report_error(stream.str().c_str());
+			exit(1);
+		}
+	}
+	else if(expr){ // new array object
 		expr->sem();
 		TSPtr expr_t(expr->get_type());
 		if(!(expr_t == INTEGER::getInstance())){
@@ -350,6 +573,8 @@ void New::sem(){
 
 void Dispose::sem(){
 	lvalue->sem();
+	mark_written(lvalue);
+	add_effect(CallableType::WritesMemory);
 	// lvalue must be of type pointer
 	TSPtr idType(lvalue->get_type());
 	if(idType->get_name().compare("pointer") ){
@@ -363,6 +588,8 @@ void Dispose::sem(){
 
 void DisposeArr::sem(){
 	lvalue->sem();
+	mark_written(lvalue);
+	add_effect(CallableType::WritesMemory);
 	// lvalue must be of type: ^array
 	TSPtr t(lvalue->get_type());
 	// try to cast as pointer
@@ -396,10 +623,111 @@ void LabelDecl::sem(){
 }
 
 void VarDecl::sem(){
+	type->resolve_sizes(this);
+	if(init){
+		if(type->get_name().compare("array") or type->is_incomplete()){
+			std::ostringstream stream;
+			stream<<"Variable '"<<id<<"' of type '"<<*type<<
+				"' can't have an initializer; only fixed-size arrays can.";
+			init->report_error(stream.str().c_str());
+			exit(1);
+		}
+		init->typecheck(type);
+	}
 	// insert variable to symbol table
 	st.insert(id,type);
 }
 
+void Initializer::typecheck(TSPtr t){
+	if(!t->get_name().compare("array")){
+		SPtr<ArrType> arr = std::static_pointer_cast<ArrType>(t);
+		int count = items ? items->size() : str.size()+1;
+		if(is_string and !(arr->get_type() == CHARACTER::getInstance())){
+			std::ostringstream stream;
+			stream<<"String \""<<str<<"\" can't initialize '"<<*t<<"'.";
+			this->report_error(stream.str().c_str());
+			exit(1);
+		}
+		if(value){
+			std::ostringstream stream;
+			stream<<"Initializer of '"<<*t<<"' should be a list '(...)' not '"
+				<<*value<<"'.";
+			this->report_error(stream.str().c_str());
+			exit(1);
+		}
+		if(count>arr->get_size()){
+			std::ostringstream stream;
+			stream<<"Initializer has "<<count<<" elements"<<
+				(is_string ? " (with terminating '\\0')" : "")<<"; '"<<*t<<
+				"' holds "<<arr->get_size()<<".";
+			this->report_error(stream.str().c_str());
+			exit(1);
+		}
+		for(uint i=0; items and i<items->size(); i++){
+			(*items)[i]->typecheck(arr->get_type());
+		}
+		return;
+	}
+	if(!value){
+		std::ostringstream stream;
+		stream<<"Element of type '"<<*t<<"' should be initialized by a constant.";
+		this->report_error(stream.str().c_str());
+		exit(1);
+	}
+	value->sem();
+	Id* name = dynamic_cast<Id*>(value);
+	if(name and !name->get_constant()){
+		std::ostringstream stream;
+		stream<<"'"<<*value<<"' in initializer is not a constant.";
+		this->report_error(stream.str().c_str());
+		exit(1);
+	}
+	if(!Let::typecheck(t, value->get_type())){
+		std::ostringstream stream;
+		stream<<"Could not initialize element of type '"<<*t<<"' with '"<<
+			*value<<"' of type '"<<*value->get_type()<<"'.";
+		this->report_error(stream.str().c_str());
+		exit(1);
+	}
+}
+
+void ConstDecl::sem(){
+	value->sem();
+	Const* literal = dynamic_cast<Const*>(value);
+	if(Id* name = dynamic_cast<Id*>(value)){
+		literal = name->get_constant();
+	}
+	if(!literal){
+		std::ostringstream stream;
+		stream<<"Value '"<<*value<<"' of constant '"<<id<<"' is not a constant.";
+		this->report_error(stream.str().c_str());
+		exit(1);
+	}
+	// insert constant with its literal to symbol table
+	st.insert(id,literal->get_type(),literal);
+}
+
+void PtrType::resolve_sizes(AST* where){
+	type->resolve_sizes(where);
+}
+
+void ArrType::resolve_sizes(AST* where){
+	if(!size_name.empty()){
+		SymbolEntry* e = st.lookup(size_name);
+		Iconst* n = e ? dynamic_cast<Iconst*>(e->value) : nullptr;
+		if(!n or n->get_num()<=0){
+			std::ostringstream stream;
+			stream<<"Size '"<<size_name<<"' of array should be a positive "
+				"integer constant.";
+			where->report_error(stream.str().c_str());
+			exit(1);
+		}
+		size = n->get_num();
+		size_name.clear();
+	}
+	type->resolve_sizes(where);
+}
+
 void DeclList::sem(){
 	for(auto p:list)
 		p->sem();
@@ -432,6 +760,22 @@ void Procedure::sem_helper(bool isFunction, TSPtr ret_type){
 
 	std::vector<TSPtr> formal_types=formals->get_type();
 	std::vector<bool> by_ref=formals->get_by_ref();
+	for(auto t: formal_types){
+		t->resolve_sizes(this);
+	}
+	if(ret_type){
+		ret_type->resolve_sizes(this);
+	}
+	for(auto t: formal_types){
+		if(!t->get_name().compare("array") and
+				std::static_pointer_cast<ArrType>(t)->get_rank()>1){
+			std::ostringstream stream;
+			stream<<"Parameter of '"<<id<<"' can't be of type '"<<*t<<
+				"'; pass a pointer to it.";
+			this->report_error(stream.str().c_str());
+			exit(1);
+		}
+	}
 	if(e){ // existent previous declaration without body.
 		// must be same type of callable (function / procedure) with
 		//   with previous declaration.
@@ -477,6 +821,18 @@ void Procedure::sem_helper(bool isFunction, TSPtr ret_type){
 		}
 		st.insert_function(id,subp_type,body);
 		type=subp_type;
+		if(body->isLibrary()){
+			// library subprograms capture none of their arguments.
+			subp_type->set_analyzed();
+			subp_type->set_library();
+			if(isReadOnly()){
+				subp_type->add_effect(CallableType::ReadsMemory);
+			}
+			else if(!isPure()){
+				// I/O subprograms.
+				subp_type->add_effect(CallableType::WritesMemory);
+			}
+		}
 		// if(body->isLibrary()){
 		// 	// library subprogram; setup type
 		// 	type = subp_type;
@@ -516,6 +872,8 @@ void Procedure::sem_helper(bool isFunction, TSPtr ret_type){
 	formals->sem();
 	body->sem();
 	st.closeScope();
+	// calls from now on can rely on the analysis of the body.
+	type->set_analyzed();
 }
 
 void Procedure::sem(){
@@ -571,6 +929,17 @@ FunctionEntry* Call::check_passing(){
 		this->report_error_from_child(stream.str().c_str());
 	}
 	body=e->body;
+	callee_type=e->type;
+	if(!body->isLibrary()){
+		// record call graph edge (needed for norecurse and effects).
+		FunctionEntry* caller = st.getParentOfCurrentScope();
+		if(caller){
+			caller->type->add_callee(e->type.get());
+		}
+	}
+	else{
+		add_effect(e->type->get_effect());
+	}
 	by_ref=e->type->get_by_ref();
 	std::vector<TSPtr> types=e->type->get_types();
 	if(types.size()!=exprs->size()){
@@ -589,6 +958,12 @@ FunctionEntry* Call::check_passing(){
 			this->report_error_from_child(stream.str().c_str());
 			exit(1);
 		}
+		if(by_ref[i]){
+			mark_addr_taken(static_cast<LValue*>(expr));
+			if(e->type->may_capture(i)){
+				mark_captured(static_cast<LValue*>(expr));
+			}
+		}
 
 		TSPtr lType(types[i]);
 		TSPtr rType(expr->get_type());
@@ -619,8 +994,12 @@ FunctionEntry* Call::check_passing(){
 	}
 
 	// add implicit vars from outer scope
+	uint idx=types.size();
 	for(auto name: e->type->get_outer_vars()){
-		Expr* i = new Id(name); i->sem();
+		Id* i = new Id(name); i->sem();
+		if(e->type->may_capture(idx++)){
+			mark_captured(i);
+		}
 		outer_vars->append(i);
 	}
 	return e;
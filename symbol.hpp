@@ -17,8 +17,10 @@ Contains symbol table and symbol entities
 
 struct SymbolEntry {
 	TSPtr type;
-	SymbolEntry() {}
-	SymbolEntry(TSPtr t) : type(t) {}
+	// literal of a named constant; nullptr for variables.
+	Const* value;
+	SymbolEntry() : value(nullptr) {}
+	SymbolEntry(TSPtr t, Const* v=nullptr) : type(t), value(v) {}
 };
 
 struct FunctionEntry {
@@ -42,12 +44,12 @@ public:
 		if (functions.find(name) == functions.end()) return nullptr;
 		return &(functions[name]);
 	}
-	void insert(std::string name, TSPtr t) {
+	void insert(std::string name, TSPtr t, Const* value=nullptr) {
 		if (locals.find(name) != locals.end()) {
 			std::cerr << "Duplicate variable " << name << std::endl;
 			exit(1);
 		}
-		locals[name] = SymbolEntry(t);
+		locals[name] = SymbolEntry(t, value);
 	}
 	void insert_function(std::string name, SPtr<CallableType> t, Body* bod) {
 		if (functions.find(name) != functions.end()) {
@@ -114,6 +116,20 @@ public:
 			if (e != nullptr) break;
 		}
 		if(e){
+			if(e->value){
+				// constant is folded at every use; never passed.
+				return e;
+			}
+			if(isGlobalScope(it-1)){
+				// program-level variable; it is emitted as a module
+				//   global so it is accessed directly (no implicit parameter).
+				return e;
+			}
+			// variable is passed by reference to nested subprogram
+			//   so it must live in memory.
+			if((it-1)->getParent()){
+				(it-1)->getParent()->type->add_addr_taken(name);
+			}
 			// add e as implicit parameter
 			//   to all scopes from 'it' to end.
 			for(auto i= it; i!=scopes.end();++i){
@@ -147,10 +163,23 @@ public:
 		scopes.back().label_lookup(lbl);
 	}
 
-	void insert(std::string name, TSPtr t) { scopes.back().insert(name, t); }
+	void insert(std::string name, TSPtr t, Const* value=nullptr) { scopes.back().insert(name, t, value); }
 	void insert_function(std::string name, SPtr<CallableType> t, Body* bod) { scopes.back().insert_function(name, t, bod); }
 	FunctionEntry *getParentOfCurrentScope() const {return scopes.back().getParent();}
+
+	bool isGlobal(std::string name){
+		// name (seen from a subprogram) resolves to a program-level variable.
+		if(scopes.size()<3 or scopes.back().lookup(name)) return false;
+		for (auto i = scopes.rbegin()+1; i != scopes.rend(); ++i) {
+			if(i->lookup(name)) return isGlobalScope(i.base()-1);
+		}
+		return false;
+	}
 private:
+	bool isGlobalScope(std::vector<Scope>::iterator i){
+		// scopes[0] holds library subprograms, scopes[1] is the program.
+		return scopes.size()>1 and i==scopes.begin()+1;
+	}
 	std::vector<Scope> scopes;
 };
 
@@ -73,6 +73,7 @@ bool PtrType::doCompare(TSPtr t){
 
 
 ArrType::ArrType(int s,TSPtr t):PtrType("array",t),size(s){}
+ArrType::ArrType(std::string s,TSPtr t):PtrType("array",t),size(0),size_name(s){}
 ArrType::ArrType(TSPtr t):PtrType("array",t),size(-1){}
 
 // Type* ArrType::clone(){
@@ -81,6 +82,10 @@ ArrType::ArrType(TSPtr t):PtrType("array",t),size(-1){}
 
 int ArrType::get_size(){return size;}
 
+int ArrType::get_rank(){return 1;}
+
+bool ArrType::is_packed(){return false;}
+
 bool ArrType::doCompare(TSPtr t){
 	if (Type::doCompare(t)){
 		if(!t->get_name().compare("any")){
@@ -88,13 +93,21 @@ bool ArrType::doCompare(TSPtr t){
 		}
 		else{
 			SPtr<ArrType> arrTy = std::static_pointer_cast<ArrType>(t);
-			return size==arrTy->get_size() and type->doCompare(arrTy->get_type());
+			// 'array of any' (length) accepts packed arrays too.
+			bool any = !type->get_name().compare("any") or
+				!arrTy->get_type()->get_name().compare("any");
+			return size==arrTy->get_size() and arrTy->get_rank()==get_rank()
+				and (arrTy->is_packed()==is_packed() or any)
+				and type->doCompare(arrTy->get_type());
 		}
 	}
 	return false;
 }
 void ArrType::printOn(std::ostream &out) const {
-	if(size>0){
+	if(!size_name.empty()){
+		out <<"array"<<"["<<size_name<<"]"<<" of "<< *type;
+	}
+	else if(size>0){
 		out <<"array"<<"["<<size<<"]"<<" of "<< *type;
 	}
 	else{
@@ -107,10 +120,29 @@ bool ArrType::is_1D(){
 	return type->get_name().compare("array");
 }
 
+MultiArrType::MultiArrType(int r, TSPtr t):ArrType(t),rank(r){}
+
+int MultiArrType::get_rank(){return rank;}
+
+void MultiArrType::printOn(std::ostream &out) const {
+	out <<"array ["<<std::string(rank-1,',')<<"] of "<< *type;
+}
+
+PackedArrType::PackedArrType(int s):ArrType(s, BOOLEAN::getInstance()){}
+PackedArrType::PackedArrType(std::string s):ArrType(s, BOOLEAN::getInstance()){}
+
+bool PackedArrType::is_packed(){return true;}
+
+void PackedArrType::printOn(std::ostream &out) const {
+	out <<"packed ";
+	ArrType::printOn(out);
+}
+
 
 CallableType::CallableType(std::string func_type, FormalDeclList* formals):
 	Type(func_type), formal_types(formals->get_type()),
-	formal_vars(formals->get_names()), by_ref(formals->get_by_ref()){}
+	formal_vars(formals->get_names()), by_ref(formals->get_by_ref()),
+	local_effect(NoMemory), analyzed(false), library(false){}
 
 bool CallableType::should_delete() const{
 	return true;
@@ -166,6 +198,128 @@ std::vector<std::string> CallableType::get_formal_vars(){
 	return formal_vars;
 }
 
+std::string CallableType::param_name(uint i){
+	// formal arguments come first, then outer arguments.
+	if(i<formal_vars.size()){
+		return formal_vars[i];
+	}
+	return outer_vars[i-formal_vars.size()];
+}
+
+void CallableType::add_captured(std::string name){
+	captured.insert(name);
+}
+
+bool CallableType::may_capture(uint i){
+	// until body is analyzed (forward or recursive call) assume the worst.
+	if(!analyzed){
+		return true;
+	}
+	return captured.find(param_name(i))!=captured.end();
+}
+
+void CallableType::add_addr_taken(std::string name){
+	addr_taken.insert(name);
+}
+
+std::set<std::string> CallableType::get_addr_taken(){
+	return addr_taken;
+}
+
+void CallableType::add_callee(CallableType* callee){
+	callees.push_back(callee);
+}
+
+bool CallableType::is_recursive(){
+	// search the call graph for a path back to this subprogram.
+	std::set<CallableType*> visited;
+	std::vector<CallableType*> stack(callees);
+	while(!stack.empty()){
+		CallableType* c = stack.back();
+		stack.pop_back();
+		if(c==this){
+			return true;
+		}
+		if(!visited.insert(c).second){
+			continue;
+		}
+		stack.insert(stack.end(), c->callees.begin(), c->callees.end());
+	}
+	return false;
+}
+
+void CallableType::set_analyzed(){
+	analyzed=true;
+}
+
+void CallableType::set_library(){
+	library=true;
+}
+
+bool CallableType::is_by_ref_param(std::string name){
+	// outer arguments are always passed by reference.
+	for(uint i=0; i<outer_vars.size(); i++){
+		if(!outer_vars[i].compare(name)) return true;
+	}
+	for(uint i=0; i<formal_vars.size(); i++){
+		if(!formal_vars[i].compare(name)) return by_ref[i];
+	}
+	return false;
+}
+
+void CallableType::add_written(std::string name){
+	written.insert(name);
+}
+
+bool CallableType::by_pointer(uint i){
+	// by-value arrays are passed as the address of the caller's array.
+	return i<formal_types.size() and !by_ref[i] and
+		!formal_types[i]->get_name().compare("array");
+}
+
+bool CallableType::is_by_pointer_param(std::string name){
+	for(uint i=0; i<formal_vars.size(); i++){
+		if(!formal_vars[i].compare(name)) return by_pointer(i);
+	}
+	return false;
+}
+
+bool CallableType::shares_array(uint i){
+	// by-value array that the body neither writes nor lets escape
+	//   is read in place; otherwise it is copied on entry.
+	if(!analyzed or !by_pointer(i)){
+		return false;
+	}
+	std::string name = formal_vars[i];
+	return written.find(name)==written.end() and
+		addr_taken.find(name)==addr_taken.end();
+}
+
+void CallableType::add_effect(Effect eff){
+	if(eff>local_effect){
+		local_effect=eff;
+	}
+}
+
+CallableType::Effect CallableType::get_effect(){
+	// strongest effect of any subprogram reachable in the call graph.
+	Effect eff = local_effect;
+	std::set<CallableType*> visited;
+	std::vector<CallableType*> stack(callees);
+	while(!stack.empty() and eff!=WritesMemory){
+		CallableType* c = stack.back();
+		stack.pop_back();
+		if(!visited.insert(c).second){
+			continue;
+		}
+		if(c->local_effect>eff){
+			eff=c->local_effect;
+		}
+		stack.insert(stack.end(), c->callees.begin(), c->callees.end());
+	}
+	return eff;
+}
+
 void CallableType::add_outer(TSPtr t, std::string name){
 	// variable that belongs to outer scope is add as implicit
 	//   argument passed by reference
@@ -205,9 +359,22 @@ TSPtr Dereference::get_type(){
 	SPtr<PtrType> p_ty = std::static_pointer_cast<PtrType>(con_ty);
 	return p_ty->get_type();
 }
+bool Brackets::is_bit(){
+	TSPtr l_ty(lvalue->get_type());
+	return std::static_pointer_cast<ArrType>(l_ty)->is_packed();
+}
+
 TSPtr Brackets::get_type(){
 	TSPtr l_ty(lvalue->get_type());
 	SPtr<ArrType> larr_ty = std::static_pointer_cast<ArrType>(l_ty);
+	int rank = larr_ty->get_rank();
+	if(rank==2){
+		// row of a 2-D array.
+		return TSPtr(new ArrType(larr_ty->get_type()));
+	}
+	if(rank>2){
+		return TSPtr(new MultiArrType(rank-1, larr_ty->get_type()));
+	}
 	return larr_ty->get_type();
 }
 TSPtr LabelDecl::get_type(){
@@ -216,6 +383,9 @@ TSPtr LabelDecl::get_type(){
 TSPtr VarDecl::get_type(){
 	return type;
 }
+TSPtr ConstDecl::get_type(){
+	return value->get_type();
+}
 TSPtr FunctionCall::get_type(){
 	return type;
 }